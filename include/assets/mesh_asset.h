@@ -64,6 +64,10 @@ public:
     AssetID material_id() const;
     const AABB& local_aabb() const;
 
+    // Kept on the CPU for collision geometry, a triangle list when indices() is empty
+    const std::vector<glm::vec3>& positions() const;
+    const std::vector<uint32_t>& indices() const;
+
 protected:
     std::ostream& print(std::ostream& os) const override;
 
@@ -74,12 +78,15 @@ private:
     AssetID m_material_id = INVALID_ASSET;
 
     AABB m_local_aabb;
+    std::vector<glm::vec3> m_positions;
+    std::vector<uint32_t> m_indices;
 
     uint32_t m_vao = 0;
     uint32_t m_vbo = 0;
     uint32_t m_ebo = 0;
 
     void compute_local_aabb(const void* vertices);
+    void copy_geometry(const void* vertices, const void* indices);
     void upload(const void* vertices, const void* indices);
 };
 
@@ -8,10 +8,19 @@
 #include <string>
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <span>
 
-enum class ColliderType { OBB, Sphere, Capsule };  // TODO implement capsule collision
+class ConvexHull;
+class TriangleMesh;
 
-using OnCollisionCallback = std::function<void(const Contact&)>;
+enum class ColliderType { OBB, Sphere, Capsule, Convex, Mesh };
+
+// What a trigger's pairs must pass to count as overlapping. Triggers never get contact points
+enum class TriggerTest { Bounds, Shape };
+
+// The pair and its contacts, empty when it ended
+using OnCollisionCallback = std::function<void(const ContactPair&, std::span<const Contact>)>;
 
 struct Collider : public IComponent {
     Collider(ColliderType type = ColliderType::OBB) : type(type) {
@@ -19,11 +28,17 @@ struct Collider : public IComponent {
 
     ColliderType type = ColliderType::OBB;
     glm::vec3 size{1.0f};    // dimensions for OBB, x radius for sphere, x radius y height for capsule
-    glm::vec3 offset{0.0f};  // local offset from the entity's origin
+    glm::vec3 offset{0.0f};  // local offset from the entity's origin, not for Convex and Mesh
     bool is_trigger = false;
+    TriggerTest trigger_test = TriggerTest::Shape;  // Bounds is enough when every trigger of a pair asks for it
     bool is_enabled = true;
     LayerMask layer = Layers::Default;
     LayerMask collides_with = 0xFFFFFFFF;  // everything
 
+    // Geometry in model space for Convex and Mesh, built from the entity's Model when left empty
+    std::shared_ptr<const ConvexHull> hull;
+    std::shared_ptr<const TriangleMesh> mesh;
+
+    // Called when a pair with this collider begins and ends touching, not in between
     OnCollisionCallback on_collision;
 };
\ No newline at end of file
@@ -3,6 +3,10 @@
 #include "components/icomponent.h"
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+
+#define RB_LOD_HOLD_TIME 1.0f  // seconds held at a finer level of detail after an interaction
 
 struct RigidBody : public IComponent {
     RigidBody(float m = 1.0f, bool _is_static = false, bool _is_kinematic = false)
@@ -14,6 +18,21 @@ struct RigidBody : public IComponent {
     float inv_mass = 1.0f;      // 1.0f / mass
     bool is_kinematic = false;  // Moved by user, not by physics
     bool is_static = false;     // Immovable
+    bool ccd = false;           // Swept against other colliders, for bodies fast enough to tunnel
+    bool can_sleep = true;      // false keeps the body and everything touching it simulated
+
+    // Sleeping bodies are neither integrated nor collision tested until woken
+    bool is_sleeping = false;
+    float sleep_timer = 0.0f;  // time spent nearly at rest
+
+    // Level of detail, set by RigidBodySystem from the distance to the closest observer. A body
+    // at level n is integrated every 2^n frames over the time since its last step. Skipped
+    // bodies collide like sleeping ones until something finer touches them
+    uint8_t lod = 0;
+    bool lod_skipped = false;
+    float lod_hold = 0.0f;   // time left held at `lod`
+    float lod_time = 0.0f;   // time since the last step
+    float step_time = 0.0f;  // time integrated over this frame, 0 when it wasn't
 
     glm::vec3 velocity{0.0f};
     glm::vec3 force_accum{0.0f};  // accumulated forces for this frame
@@ -36,6 +55,10 @@ struct RigidBody : public IComponent {
         force_accum += force;
 
         if (inv_mass > 0.0f) {
+            if (force != glm::vec3(0.0f)) {
+                wake();
+                promote();
+            }
             glm::vec3 acceleration = force_accum * inv_mass;
             velocity += acceleration * dt;
         }
@@ -43,8 +66,24 @@ struct RigidBody : public IComponent {
 
     // v += impulse * inv_mass
     void apply_impulse(const glm::vec3& impulse) {
-        if (inv_mass > 0.0f) {
+        if (inv_mass > 0.0f && impulse != glm::vec3(0.0f)) {
             velocity += impulse * inv_mass;
+            wake();
+            promote();
+        }
+    }
+
+    // Holds the body at `level` or finer for a while, full rate by default
+    void promote(uint8_t level = 0) {
+        lod = std::min(lod, level);
+        lod_hold = RB_LOD_HOLD_TIME;
+    }
+
+    // Starts the sleep timer over only for sleeping bodies, gravity is a force too
+    void wake() {
+        if (is_sleeping) {
+            is_sleeping = false;
+            sleep_timer = 0.0f;
         }
     }
 
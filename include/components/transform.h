@@ -4,6 +4,7 @@
 #include "components/icomponent.h"
 
 #include <cmath>
+#include <cstdint>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -28,7 +29,10 @@ public:
         return m_position;
     }
 
+    // Counted as a change, the caller may write through it
     glm::vec3& position_mut() {
+        dirty = true;
+        m_version++;
         return m_position;
     }
 
@@ -41,9 +45,16 @@ public:
     }
 
     glm::vec3& scale_mut() {
+        dirty = true;
+        m_version++;
         return m_scale;
     }
 
+    // Bumped on every change, for caches of anything derived from the transform
+    uint32_t version() const {
+        return m_version;
+    }
+
     const glm::mat4& model_matrix() {
         compute_model_matrix();
         return m_model_matrix;
@@ -58,6 +69,7 @@ public:
 
         m_position = pos;
         dirty = true;
+        m_version++;
     }
     void set_rotation(const glm::quat& rot) {
         glm::quat rot_norm = glm::normalize(rot);
@@ -68,6 +80,7 @@ public:
 
         m_rotation = rot_norm;
         dirty = true;
+        m_version++;
     }
     void set_scale(const glm::vec3& sc) {
         if (glm::all(glm::epsilonEqual(m_scale, sc, TR_SCALE_EPS))) {
@@ -76,6 +89,7 @@ public:
 
         m_scale = sc;
         dirty = true;
+        m_version++;
     }
 
     // UPDATERS
@@ -87,6 +101,7 @@ public:
 
         m_position += delta;
         dirty = true;
+        m_version++;
     }
     void update_rotation(const glm::quat& delta) {
         glm::quat delta_nor = glm::normalize(delta);
@@ -100,6 +115,7 @@ public:
         // Quaternion multiplication to rotate incrementally
         m_rotation = glm::normalize(delta_nor * m_rotation);
         dirty = true;
+        m_version++;
     }
     void update_scale(const glm::vec3& delta) {
         if (glm::all(glm::epsilonEqual(delta, glm::vec3(0.0f), TR_SCALE_EPS))) {
@@ -108,6 +124,7 @@ public:
 
         m_scale += delta;
         dirty = true;
+        m_version++;
     }
 
 private:
@@ -117,6 +134,7 @@ private:
     glm::mat4 m_model_matrix{1.0f};
 
     bool dirty = true;
+    uint32_t m_version = 0;
 
     void compute_model_matrix() {
         if (!dirty) {
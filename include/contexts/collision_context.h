@@ -2,9 +2,39 @@
 
 #include "contexts/icontext.h"
 #include "core/types/contact.h"
+#include "core/types/layers.h"
+#include "physics/broadphase.h"
+#include "physics/partitioned_broadphase.h"
+#include "physics/scene_query.h"
 
 #include <vector>
+#include <memory>
+#include <cstdint>
 
 struct CollisionContext : public IContext {
-    std::vector<Contact> contacts;
-};
\ No newline at end of file
+    std::vector<Contact> contacts;  // sorted by pair, a pair may have several
+
+    // Every touching pair and those that stopped touching this frame
+    std::vector<ContactPair> pairs;
+
+    // Which layers may collide, on top of each collider's own collides_with
+    LayerMatrix layers;
+
+    // Strategy for the dynamic colliders, static ones always live in their own tree.
+    // Swapping through here is safe at any time, the detection system sees the new
+    // generation and recreates its proxies
+    void set_broadphase(BroadphaseType type) {
+        broadphase_type = type;
+        broadphase = std::make_unique<PartitionedBroadphase>(make_broadphase(type));
+        broadphase_generation++;
+    }
+
+    BroadphaseType broadphase_type = BroadphaseType::SAP;
+    std::unique_ptr<IBroadphase> broadphase = std::make_unique<PartitionedBroadphase>(make_broadphase(broadphase_type));
+    uint64_t broadphase_generation = 0;  // bumped by every swap, a new one may reuse the old one's address
+
+    float broadphase_ms = 0.0f;  // time spent in the last update_pairs(), to compare strategies
+
+    // Raycasts and overlap tests against the colliders as of the last collision detection
+    SceneQuery queries;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <type_traits>
+
+enum class Access { Read, Write };
+
+// Stable handle to a context owned by the ContextManager, fetched once (usually in a
+// system's init). ContextRef<const T> marks read-only access, ContextRef<T> read/write
+template <typename T>
+class ContextRef {
+public:
+    static constexpr Access access = std::is_const_v<T> ? Access::Read : Access::Write;
+
+    ContextRef() = default;
+
+    explicit ContextRef(T* context) : m_context(context) {
+    }
+
+    T& operator*() const {
+        return *m_context;
+    }
+
+    T* operator->() const {
+        return m_context;
+    }
+
+    explicit operator bool() const {
+        return m_context != nullptr;
+    }
+
+private:
+    T* m_context = nullptr;
+};
+
+// Declares which contexts a system touches: `const T` for reads, `T` for writes, which
+// includes subscribing to events and registering input actions. Only contexts are covered:
+// two systems without conflicting contexts may still write the same components (e.g. both
+// physics systems write RigidBody), so a parallel scheduler must order those on its own
+template <typename... Contexts>
+struct ContextAccess {
+    template <typename T>
+    static constexpr bool reads = (std::is_same_v<std::remove_const_t<Contexts>, T> || ...);
+
+    template <typename T>
+    static constexpr bool writes = ((std::is_same_v<Contexts, T> && !std::is_const_v<Contexts>) || ...);
+};
+
+namespace detail {
+template <typename A, typename... Bs>
+constexpr bool access_conflicts_one() {
+    return ((std::is_same_v<std::remove_const_t<A>, std::remove_const_t<Bs>> &&
+             (!std::is_const_v<A> || !std::is_const_v<Bs>)) ||
+            ...);
+}
+}  // namespace detail
+
+template <typename A, typename B>
+struct AccessConflict;
+
+// Two accesses conflict if they share a context and at least one of them writes it
+template <typename... As, typename... Bs>
+struct AccessConflict<ContextAccess<As...>, ContextAccess<Bs...>> {
+    static constexpr bool value = (detail::access_conflicts_one<As, Bs...>() || ...);
+};
+
+template <typename A, typename B>
+constexpr bool access_conflicts = AccessConflict<A, B>::value;
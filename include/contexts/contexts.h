@@ -2,7 +2,7 @@
 
 class EventContext;
 class PhysicsContext;
-class CollisionSolverContext;
+class CollisionContext;
 class InputContext;
 class CameraContext;
 class RenderContext;
@@ -2,51 +2,298 @@
 
 #include "contexts/icontext.h"
 #include "events/events.h"
+#include "core/types/type_id.h"
+#include "core/types/key_index.h"
+#include "core/timer_wheel.h"
+#include "core/event_lane.h"
 
-#include <unordered_map>
-#include <memory>
+#include <array>
+#include <atomic>
 #include <vector>
+#include <unordered_map>
 #include <functional>
-#include <typeindex>
-#include <queue>
+#include <span>
+#include <stdexcept>
+#include <format>
+
+#define MAX_EVENT_TYPES 64
+#define EVENT_HISTORY_PRUNE_FRAMES 64
 
+// Events are stored by value in one queue per type, indexed by TypeIndex<IEvent>.
+// Subscribers receive every pending event of their type in one batch.
+//
+// A per-type EventPolicy coalesces keyed events: duplicates are folded at emit time
+// inside each lane, then across lanes and frames when the lanes are merged.
+// advance() must be called once per frame for the frame/time based policies and
+// to fire events scheduled with schedule(), which are emitted on the main lane.
+//
+// emit() may be called from thread pool jobs: each chunk appends to its own lane, set
+// by the pool, so producers never lock or block. Lanes are merged in lane order at
+// dispatch. subscribe() and dispatch() must run on the main thread while no
+// worker is emitting
 class EventContext : public IContext {
 public:
     template <typename T>
         requires std::is_base_of_v<IEvent, T>
-    using Callback = std::function<void(const T&)>;
+    using Callback = std::function<void(std::span<const T>)>;
+
+    EventContext() = default;
+
+    ~EventContext() {
+        for (auto& q : m_queues) {
+            delete q.load(std::memory_order_relaxed);
+        }
+    }
 
     template <typename T>
         requires std::is_base_of_v<IEvent, T>
     void emit(const T& event) {
-        m_queue.push(std::make_shared<T>(event));
+        queue<T>().push(event);
+    }
+
+    // Call before emitting events of this type
+    template <typename T>
+        requires std::is_base_of_v<IEvent, T> && KeyedEvent<T>
+    void set_policy(EventPolicy policy) {
+        queue<T>().policy = policy;
+    }
+
+    // Emits `event` after `delay` seconds, then every `period` seconds if period > 0.
+    // Main thread only
+    template <typename T>
+        requires std::is_base_of_v<IEvent, T>
+    TimerHandle schedule(float delay, const T& event, float period = 0.0f) {
+        uint32_t payload = queue<T>().store(event);
+        return m_timers.schedule(delay, period, TypeIndex<IEvent>::get<T>(), payload);
+    }
+
+    bool cancel(TimerHandle handle) {
+        uint32_t kind;
+        uint32_t payload;
+        if (!m_timers.cancel(handle, kind, payload)) {
+            return false;
+        }
+
+        m_queues[kind].load(std::memory_order_acquire)->release(payload);
+        return true;
+    }
+
+    bool is_scheduled(TimerHandle handle) const {
+        return m_timers.is_pending(handle);
+    }
+
+    // Advances the frame clock used by coalescing policies and timers
+    void advance(float dt) {
+        m_clock.frame++;
+        m_clock.time += dt;
+
+        // Expired timers are emitted in deadline order
+        m_timers.advance(dt, m_expired);
+        for (const ExpiredTimer& t : m_expired) {
+            m_queues[t.kind].load(std::memory_order_acquire)->fire(t.payload, !t.repeating);
+        }
+        m_expired.clear();
+
+        if (m_clock.frame % EVENT_HISTORY_PRUNE_FRAMES == 0) {
+            for (auto& q : m_queues) {
+                IEventQueue* queue = q.load(std::memory_order_acquire);
+                if (queue) {
+                    queue->prune(m_clock);
+                }
+            }
+        }
     }
 
     template <typename T>
         requires std::is_base_of_v<IEvent, T>
     void subscribe(Callback<T> cb) {
-        auto& callbacks = m_subscribers[typeid(T)];
-        callbacks.push_back([cb](const std::shared_ptr<IEvent>& base_event) {
-            auto* event = static_cast<T*>(base_event.get());
-            cb(*event);
-        });
+        queue<T>().subscribers.push_back(std::move(cb));
     }
 
+    // Delivers pending events until every queue is drained, so events emitted
+    // by subscribers are delivered in the same dispatch
     void dispatch() {
-        while (!m_queue.empty()) {
-            std::shared_ptr<IEvent> event = m_queue.front();
-            m_queue.pop();
-
-            auto it = m_subscribers.find(typeid(*event));
-            if (it != m_subscribers.end()) {
-                for (auto& cb : it->second) {
-                    cb(event);
+        bool delivered = true;
+        while (delivered) {
+            delivered = false;
+            for (auto& q : m_queues) {
+                IEventQueue* queue = q.load(std::memory_order_acquire);
+                if (queue && queue->dispatch(m_clock)) {
+                    delivered = true;
                 }
             }
         }
     }
 
 private:
-    std::queue<std::shared_ptr<IEvent>> m_queue;
-    std::unordered_map<std::type_index, std::vector<std::function<void(std::shared_ptr<IEvent>)>>> m_subscribers;
-};
\ No newline at end of file
+    struct Clock {
+        uint64_t frame = 0;
+        double time = 0.0;
+    };
+
+    struct IEventQueue {
+        virtual ~IEventQueue() = default;
+        virtual bool dispatch(const Clock& clock) = 0;
+        virtual void prune(const Clock& clock) = 0;
+        virtual void fire(uint32_t payload, bool release) = 0;
+        virtual void release(uint32_t payload) = 0;
+    };
+
+    template <typename T>
+    struct EventQueue : public IEventQueue {
+        // Own cache lines, producers on neighbouring lanes don't share them
+        struct alignas(64) Lane {
+            std::vector<T> events;
+            KeyIndex keys;  // key -> position in events
+        };
+
+        // When a key was last delivered
+        struct History {
+            uint64_t frame = 0;
+            double time = 0.0;
+        };
+
+        std::array<Lane, MAX_EVENT_LANES> lanes;
+        Lane batch;  // merged lanes being delivered
+        std::vector<Callback<T>> subscribers;
+        EventPolicy policy;
+        std::unordered_map<uint64_t, History> history;  // only touched on the main thread
+        std::vector<T> scheduled;                        // events waiting on a timer
+        std::vector<uint32_t> free_scheduled;
+
+        void push(const T& event) {
+            Lane& lane = lanes[t_event_lane];
+            if (policy.mode == Coalesce::None) {
+                lane.events.push_back(event);
+            } else {
+                coalesce(lane, event);
+            }
+        }
+
+        bool dispatch(const Clock& clock) override {
+            for (Lane& lane : lanes) {
+                for (const T& event : lane.events) {
+                    if (policy.mode == Coalesce::None) {
+                        batch.events.push_back(event);
+                    } else if (admit(event, clock)) {
+                        coalesce(batch, event);
+                    }
+                }
+                lane.events.clear();
+                lane.keys.clear();
+            }
+
+            if (batch.events.empty()) {
+                return false;
+            }
+
+            std::span<const T> events(batch.events);
+            for (auto& cb : subscribers) {
+                cb(events);
+            }
+            batch.events.clear();
+            batch.keys.clear();
+
+            return true;
+        }
+
+        uint32_t store(const T& event) {
+            if (free_scheduled.empty()) {
+                scheduled.push_back(event);
+                return static_cast<uint32_t>(scheduled.size() - 1);
+            }
+
+            uint32_t i = free_scheduled.back();
+            free_scheduled.pop_back();
+            scheduled[i] = event;
+            return i;
+        }
+
+        void fire(uint32_t payload, bool release_payload) override {
+            push(scheduled[payload]);
+            if (release_payload) {
+                release(payload);
+            }
+        }
+
+        void release(uint32_t payload) override {
+            free_scheduled.push_back(payload);
+        }
+
+        void prune(const Clock& clock) override {
+            std::erase_if(history, [&](const auto& entry) {
+                const History& h = entry.second;
+                return h.frame + 1 < clock.frame && clock.time - h.time >= policy.min_interval;
+            });
+        }
+
+        void coalesce(Lane& lane, const T& event) {
+            if constexpr (KeyedEvent<T>) {
+                bool inserted;
+                uint32_t& i = lane.keys.find_or_insert(event.key(), lane.events.size(), inserted);
+                if (inserted) {
+                    lane.events.push_back(event);
+                } else if (policy.mode == Coalesce::LatestPerKey) {
+                    lane.events[i] = event;
+                }
+            } else {
+                lane.events.push_back(event);
+            }
+        }
+
+        // Cross-frame filtering, applied once lanes are merged
+        bool admit(const T& event, const Clock& clock) {
+            if constexpr (KeyedEvent<T>) {
+                if (policy.mode == Coalesce::LatestPerKey) {
+                    return true;
+                }
+
+                auto [it, inserted] = history.try_emplace(event.key(), History{clock.frame, clock.time});
+                History& h = it->second;
+                if (inserted) {
+                    return true;
+                }
+
+                bool admitted = false;
+                if (policy.mode == Coalesce::MergeByPair) {
+                    // Still in contact since the previous frame: not a new event
+                    admitted = h.frame + 1 < clock.frame;
+                    h.frame = clock.frame;
+                } else if (clock.time - h.time >= policy.min_interval) {
+                    admitted = true;
+                    h.time = clock.time;
+                }
+
+                return admitted;
+            } else {
+                return true;
+            }
+        }
+    };
+
+    std::array<std::atomic<IEventQueue*>, MAX_EVENT_TYPES> m_queues{};
+    Clock m_clock;
+    TimerWheel m_timers;
+    std::vector<ExpiredTimer> m_expired;
+
+    // Lock-free: concurrent first emits of a type race to install the queue, losers discard theirs
+    template <typename T>
+    EventQueue<T>& queue() {
+        TypeID i = TypeIndex<IEvent>::get<T>();
+        if (i >= MAX_EVENT_TYPES) {
+            throw std::runtime_error("[EventContext] Too many event types, raise MAX_EVENT_TYPES!");
+        }
+
+        IEventQueue* q = m_queues[i].load(std::memory_order_acquire);
+        if (!q) {
+            auto* created = new EventQueue<T>();
+            if (m_queues[i].compare_exchange_strong(q, created, std::memory_order_acq_rel)) {
+                q = created;
+            } else {
+                delete created;
+            }
+        }
+
+        return *static_cast<EventQueue<T>*>(q);
+    }
+};
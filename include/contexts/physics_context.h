@@ -3,10 +3,21 @@
 #include "contexts/icontext.h"
 
 #include <glm/glm.hpp>
+#include <cstdint>
+
+#define PHYSICS_LOD_LEVELS 3  // full, half and quarter rate
 
 struct PhysicsContext : public IContext {
     glm::vec3 gravity;
     float dt = 0.0f;
+    uint32_t solver_iterations = 8;  // velocity passes over all contact points, more converge stacks better
+
+    // Level of detail: bodies farther than lod_distances[n] from every camera and sound
+    // listener are integrated every 2^(n+1) frames. Bodies no camera sees count as
+    // farther, the distances are scaled by lod_hidden_scale for them
+    bool lod_enabled = true;
+    float lod_distances[PHYSICS_LOD_LEVELS - 1] = {40.0f, 100.0f};
+    float lod_hidden_scale = 0.5f;
 
     PhysicsContext(const glm::vec3& gravity = glm::vec3(0.0f, -9.81f, 0.0f)) : gravity(gravity) {
     }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "core/thread_pool.h"
+
+#include <format>
+#include <stdexcept>
+#include <cstdint>
+
+#define MAX_EVENT_LANES (1 + THREAD_POOL_MAX_CHUNKS)  // lane 0 is the main thread, then one per pool chunk
+
+// Lane the calling thread emits into. The thread pool sets it for each chunk it runs
+inline thread_local uint32_t t_event_lane = 0;
+
+// Routes the events emitted by this thread into the given lane while in scope.
+// Lanes go by job index (not by OS thread) to keep dispatch order reproducible
+class EventLaneScope {
+public:
+    explicit EventLaneScope(uint32_t lane) : m_prev(t_event_lane) {
+        if (lane >= MAX_EVENT_LANES) {
+            throw std::runtime_error(std::format("[EventContext] Event lane {} is out of range!", lane));
+        }
+        t_event_lane = lane;
+    }
+
+    ~EventLaneScope() {
+        t_event_lane = m_prev;
+    }
+
+    EventLaneScope(const EventLaneScope&) = delete;
+    EventLaneScope& operator=(const EventLaneScope&) = delete;
+
+private:
+    uint32_t m_prev;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#define THREAD_POOL_MAX_THREADS 64  // calling thread included
+#define THREAD_POOL_CHUNKS_PER_THREAD 4
+#define THREAD_POOL_MAX_CHUNKS (THREAD_POOL_MAX_THREADS * THREAD_POOL_CHUNKS_PER_THREAD)  // one event lane each
+
+// Fixed set of worker threads that help the calling thread run jobs split in chunks.
+// Jobs are meant to be issued from the main thread, a job started from inside
+// another job runs serially on the calling thread
+class ThreadPool {
+public:
+    // Shared pool sized to the hardware
+    static ThreadPool& get();
+
+    explicit ThreadPool(uint32_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Threads taking part in a job, the calling one included
+    uint32_t threads() const {
+        return static_cast<uint32_t>(m_workers.size()) + 1;
+    }
+
+    // Calls job(chunk) for every chunk in [0, chunks) and returns once all are done.
+    // Events emitted by chunk c go to event lane 1 + c, or to the outer job's lane when nested
+    void run(uint32_t chunks, const std::function<void(uint32_t)>& job);
+
+private:
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+
+    const std::function<void(uint32_t)>* m_job = nullptr;
+    uint32_t m_chunks = 0;
+    std::atomic<uint64_t> m_next = 0;  // generation << 32 | next chunk, stale workers can't claim new chunks
+    std::atomic<uint32_t> m_done = 0;
+
+    void worker_loop();
+    void work(uint64_t generation, uint32_t chunks, const std::function<void(uint32_t)>& job);
+};
+
+// Number of chunks parallel_for() splits `count` items in, at least `grain` items each.
+// Lets callers size per-chunk output buffers
+inline uint32_t parallel_chunks(uint32_t count, uint32_t grain) {
+    if (count == 0) {
+        return 0;
+    }
+
+    grain = grain > 0 ? grain : 1;
+    uint32_t max_chunks = ThreadPool::get().threads() * THREAD_POOL_CHUNKS_PER_THREAD;
+    uint32_t chunks = (count + grain - 1) / grain;
+    return chunks < max_chunks ? chunks : max_chunks;
+}
+
+// Calls fn(begin, end, chunk) over contiguous ranges of [0, count). Chunk boundaries only
+// depend on the arguments and the thread count, so results written per chunk and merged
+// in chunk order are the same as a serial loop
+template <typename F>
+void parallel_for(uint32_t count, uint32_t grain, F&& fn) {
+    uint32_t chunks = parallel_chunks(count, grain);
+    ThreadPool::get().run(chunks, [&](uint32_t chunk) {
+        uint32_t begin = static_cast<uint32_t>(uint64_t(count) * chunk / chunks);
+        uint32_t end = static_cast<uint32_t>(uint64_t(count) * (chunk + 1) / chunks);
+        fn(begin, end, chunk);
+    });
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 8
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_SLOT_BITS)
+#define INVALID_TIMER 0xFFFFFFFFu
+
+struct TimerHandle {
+    uint32_t index = INVALID_TIMER;
+    uint32_t generation = 0;
+
+    bool valid() const {
+        return index != INVALID_TIMER;
+    }
+};
+
+struct ExpiredTimer {
+    uint32_t kind;     // user defined, e.g. the event type
+    uint32_t payload;  // user defined, e.g. the slot of the scheduled event
+    bool repeating;    // still scheduled after this expiration
+};
+
+// Hierarchical timing wheel. Timers are intrusive list nodes in a pool, so schedule
+// and cancel are O(1) and advancing only touches the slots that expire or cascade.
+// Level 0 has one slot per tick, every further level covers TIMER_WHEEL_SLOTS times more
+class TimerWheel {
+public:
+    explicit TimerWheel(float tick_seconds = 0.001f);
+
+    // Delays are rounded to ticks (at least one). A period > 0 makes the timer repeat
+    TimerHandle schedule(float delay, float period, uint32_t kind, uint32_t payload);
+
+    // Returns false if the timer already expired or was cancelled. On success
+    // writes the timer's kind and payload so the caller can release them
+    bool cancel(TimerHandle handle, uint32_t& kind, uint32_t& payload);
+    bool is_pending(TimerHandle handle) const;
+
+    // Advances the wheel by dt seconds, appending every expiration to `expired` in deadline order
+    void advance(float dt, std::vector<ExpiredTimer>& expired);
+
+    uint32_t size() const {
+        return m_size;
+    }
+
+private:
+    struct Node {
+        uint64_t deadline = 0;  // in ticks
+        uint32_t period = 0;    // in ticks, 0 for one-shot
+        uint32_t kind = 0;
+        uint32_t payload = 0;
+        uint32_t prev = INVALID_TIMER;
+        uint32_t next = INVALID_TIMER;  // also links the free list
+        uint32_t slot = INVALID_TIMER;  // level * TIMER_WHEEL_SLOTS + slot, INVALID_TIMER if not scheduled
+        uint32_t generation = 0;
+    };
+
+    double m_tick;
+    double m_accum = 0.0;  // seconds not yet turned into ticks
+    uint64_t m_now = 0;    // current tick
+    uint32_t m_size = 0;
+
+    std::vector<Node> m_nodes;
+    uint32_t m_free = INVALID_TIMER;
+    std::array<uint32_t, TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS> m_slots;
+
+    uint32_t to_ticks(float seconds) const;
+    uint32_t alloc_node();
+    void free_node(uint32_t i);
+    void link(uint32_t i);
+    void unlink(uint32_t i);
+    void cascade(uint32_t level);
+    void tick(std::vector<ExpiredTimer>& expired);
+};
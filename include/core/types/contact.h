@@ -3,6 +3,19 @@
 #include "core/types/id.h"
 
 #include <glm/glm.hpp>
+#include <cstdint>
+
+#define CONTACT_MAX_POINTS 4
+
+struct ContactPoint {
+    glm::vec3 position{0.0f};
+    float penetration = 0.0f;
+    uint32_t feature = 0;  // pair of features that produced the point, stable across frames
+
+    // Accumulated by the solver and carried to the next frame to warm start it
+    float normal_impulse = 0.0f;
+    glm::vec2 tangent_impulse{0.0f};
+};
 
 struct Contact {
     EntityID a;
@@ -11,4 +24,19 @@ struct Contact {
     glm::vec3 position{0.0f};
     glm::vec3 normal{0.0f};  // points from A to B
     bool is_trigger = false;
-};
\ No newline at end of file
+
+    ContactPoint points[CONTACT_MAX_POINTS];
+    uint32_t point_count = 0;
+};
+
+enum class ContactPhase { Begin, Persist, End };
+
+// A pair of colliders touching this frame, or that stopped touching this frame (End)
+struct ContactPair {
+    EntityID a;
+    EntityID b;
+    ContactPhase phase = ContactPhase::Begin;
+    bool is_trigger = false;
+    uint32_t first = 0;  // its contacts in CollisionContext::contacts, none once it ended
+    uint32_t count = 0;
+};
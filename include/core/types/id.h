@@ -6,4 +6,9 @@ using EntityID = uint32_t;
 using AssetID = uint64_t;
 
 #define INVALID_ENTITY 0
-#define INVALID_ASSET 0
\ No newline at end of file
+#define INVALID_ASSET 0
+
+// Order-independent key for a pair of entities
+inline uint64_t pair_key(EntityID a, EntityID b) {
+    return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
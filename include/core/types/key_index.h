@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Open-addressing map from 64-bit keys to 32-bit values for short-lived lookups
+// (e.g. per-frame de-duplication). clear() is O(1) and keeps the storage
+class KeyIndex {
+public:
+    // Returns the value stored for key, inserting `value` if the key is new
+    uint32_t& find_or_insert(uint64_t key, uint32_t value, bool& inserted) {
+        if ((m_size + 1) * 2 > m_slots.size()) {
+            grow();
+        }
+
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = hash(key) & mask;; i = (i + 1) & mask) {
+            Slot& s = m_slots[i];
+            if (s.stamp != m_stamp) {
+                s = Slot{key, value, m_stamp};
+                m_size++;
+                inserted = true;
+                return s.value;
+            }
+            if (s.key == key) {
+                inserted = false;
+                return s.value;
+            }
+        }
+    }
+
+    void clear() {
+        m_size = 0;
+        if (++m_stamp == 0) {
+            // Stamp wrapped around, old slots could look live again
+            for (Slot& s : m_slots) {
+                s.stamp = 0;
+            }
+            m_stamp = 1;
+        }
+    }
+
+    uint32_t size() const {
+        return m_size;
+    }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        uint32_t value = 0;
+        uint32_t stamp = 0;  // live if equal to m_stamp
+    };
+
+    std::vector<Slot> m_slots;
+    uint32_t m_stamp = 1;
+    uint32_t m_size = 0;
+
+    static size_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+
+    void grow() {
+        std::vector<Slot> old = std::move(m_slots);
+        m_slots.assign(old.empty() ? 16 : old.size() * 2, Slot{});
+
+        uint32_t stamp = m_stamp;
+        m_stamp = 1;
+        m_size = 0;
+        for (const Slot& s : old) {
+            if (s.stamp == stamp) {
+                bool inserted;
+                find_or_insert(s.key, s.value, inserted);
+            }
+        }
+    }
+};
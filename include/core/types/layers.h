@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <bit>
 #include <cstdint>
 
 using LayerMask = uint32_t;
@@ -7,4 +9,40 @@ namespace Layers {
 constexpr LayerMask Default = 1 << 0;
 constexpr LayerMask Ground = 1 << 1;
 constexpr LayerMask Player = 1 << 2;
-}  // namespace Layers
\ No newline at end of file
+}  // namespace Layers
+
+// Symmetric table of which layers may collide with each other, everything by default
+class LayerMatrix {
+public:
+    LayerMatrix() {
+        m_rows.fill(0xFFFFFFFF);
+    }
+
+    // Every layer of `a` against every layer of `b`
+    void set(LayerMask a, LayerMask b, bool collide) {
+        for (LayerMask bits = a; bits; bits &= bits - 1) {
+            uint32_t i = std::countr_zero(bits);
+            m_rows[i] = collide ? (m_rows[i] | b) : (m_rows[i] & ~b);
+        }
+        for (LayerMask bits = b; bits; bits &= bits - 1) {
+            uint32_t i = std::countr_zero(bits);
+            m_rows[i] = collide ? (m_rows[i] | a) : (m_rows[i] & ~a);
+        }
+    }
+
+    // Layers that may collide with any layer of `layer`
+    LayerMask mask_for(LayerMask layer) const {
+        LayerMask mask = 0;
+        for (LayerMask bits = layer; bits; bits &= bits - 1) {
+            mask |= m_rows[std::countr_zero(bits)];
+        }
+        return mask;
+    }
+
+    bool collides(LayerMask a, LayerMask b) const {
+        return (mask_for(a) & b) != 0;
+    }
+
+private:
+    std::array<LayerMask, 32> m_rows;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+using TypeID = uint32_t;
+
+// Dense type ids assigned on first use, so they can index flat arrays.
+// Every Family (e.g. IContext, IEvent) counts from 0 independently
+template <typename Family>
+class TypeIndex {
+public:
+    template <typename T>
+    static TypeID get() {
+        return id_of<std::remove_cvref_t<T>>();
+    }
+
+    // Number of ids handed out so far
+    static TypeID count() {
+        return s_counter.load(std::memory_order_relaxed);
+    }
+
+private:
+    static inline std::atomic<TypeID> s_counter{0};
+
+    template <typename T>
+    static TypeID id_of() {
+        static const TypeID id = s_counter.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+};
@@ -7,6 +7,11 @@ struct CollisionEvent : public IEvent {
     CollisionEvent(EntityID a, EntityID b) : a(a), b(b) {
     }
 
+    // Coalescing key, the same for (a, b) and (b, a)
+    uint64_t key() const {
+        return pair_key(a, b);
+    }
+
     EntityID a;
     EntityID b;
 };
\ No newline at end of file
@@ -1,5 +1,26 @@
 #pragma once
 
+#include <concepts>
+#include <cstdint>
+
 struct IEvent {
     virtual ~IEvent() = default;
-};
\ No newline at end of file
+};
+
+// Events that can be coalesced expose a key (e.g. an entity or an entity pair)
+template <typename T>
+concept KeyedEvent = requires(const T& e) {
+    { e.key() } -> std::convertible_to<uint64_t>;
+};
+
+enum class Coalesce {
+    None,             // deliver every event
+    LatestPerKey,     // keep only the last event per key in a dispatch
+    MergeByPair,      // keep the first event per key, and drop keys already reported the previous frame
+    RateLimitPerKey,  // deliver at most one event per key every min_interval seconds
+};
+
+struct EventPolicy {
+    Coalesce mode = Coalesce::None;
+    float min_interval = 0.0f;  // seconds, for RateLimitPerKey
+};
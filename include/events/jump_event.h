@@ -7,5 +7,9 @@ struct JumpEvent : public IEvent {
     JumpEvent(EntityID e) : entity(e) {
     }
 
+    uint64_t key() const {
+        return entity;
+    }
+
     EntityID entity;
 };
\ No newline at end of file
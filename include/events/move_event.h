@@ -9,6 +9,10 @@ struct MoveEvent : public IEvent {
     MoveEvent(EntityID e, glm::vec3 direction) : entity(e), direction(std::move(direction)) {
     }
 
+    uint64_t key() const {
+        return entity;
+    }
+
     EntityID entity;
     glm::vec3 direction;
 };
\ No newline at end of file
@@ -2,41 +2,57 @@
 
 #include "contexts/icontext.h"
 #include "contexts/contexts.h"
+#include "contexts/context_ref.h"
+#include "core/types/type_id.h"
 #include "core/types/type_name.h"
 #include "core/log.h"
 
-#include <unordered_map>
-#include <typeindex>
+#include <vector>
 #include <memory>
 #include <stdexcept>
 #include <format>
 
+// Contexts live in a flat array indexed by their TypeIndex<IContext> id. Adding is
+// expected to happen during setup; once running, lookups are read-only and safe
+// to perform concurrently
 class ContextManager {
 public:
     template <typename T, typename... Args>
         requires std::is_base_of_v<IContext, T>
     T& add(Args&&... args) {
-        std::type_index i(typeid(T));
-        auto [it, added] = m_contexts.try_emplace(i, std::make_unique<T>(std::forward<Args>(args)...));
-        if (added) {
+        TypeID i = TypeIndex<IContext>::get<T>();
+        if (i >= m_contexts.size()) {
+            m_contexts.resize(i + 1);
+        }
+
+        if (!m_contexts[i]) {
+            m_contexts[i] = std::make_unique<T>(std::forward<Args>(args)...);
             LOG("[ContextManager] Added " << readable_type_name<T>());
         }
 
-        return *static_cast<T*>(it->second.get());
+        return *static_cast<T*>(m_contexts[i].get());
     }
 
     template <typename T>
         requires std::is_base_of_v<IContext, T>
     T& get() {
-        std::type_index i(typeid(T));
-        if (!m_contexts.contains(i)) {
+        TypeID i = TypeIndex<IContext>::get<T>();
+        if (i >= m_contexts.size() || !m_contexts[i]) {
             throw std::runtime_error(
                 std::format("[ContextManager] Trying to fetch {} which wasn't added!", readable_type_name<T>()));
         }
 
-        return *static_cast<T*>(m_contexts.at(i).get());
+        return *static_cast<T*>(m_contexts[i].get());
+    }
+
+    // Returns a handle that stays valid for the lifetime of the manager.
+    // Use ref<const T>() for read-only access
+    template <typename T>
+        requires std::is_base_of_v<IContext, std::remove_const_t<T>>
+    ContextRef<T> ref() {
+        return ContextRef<T>(&get<std::remove_const_t<T>>());
     }
 
 private:
-    std::unordered_map<std::type_index, std::unique_ptr<IContext>> m_contexts;
-};
\ No newline at end of file
+    std::vector<std::unique_ptr<IContext>> m_contexts;
+};
@@ -37,12 +37,14 @@ public:
 
         m_names.erase(entity_id);
         m_free_ids.push_back(entity_id);
+        m_structure_version++;
     }
 
     // Attach a certain component to an entity
     template <typename T, typename... Args>
         requires std::is_base_of_v<IComponent, T>
     T& add(EntityID entity_id, Args&&... args) {
+        m_structure_version++;
         return get_pool<T>().add(entity_id, std::forward<Args>(args)...);
     }
 
@@ -86,6 +88,7 @@ public:
         requires std::is_base_of_v<IComponent, T>
     void remove_component(EntityID entity_id) {
         get_pool<T>().remove_component(entity_id);
+        m_structure_version++;
     }
 
     // Removes the certain components attached to the entity. Might throw
@@ -117,6 +120,12 @@ public:
                });
     }
 
+    // Bumped whenever a component is added or removed. Components never move in memory
+    // until they're removed, so pointers gathered from them stay valid while it's the same
+    uint64_t structure_version() const {
+        return m_structure_version;
+    }
+
     const std::string& get_name(EntityID entity_id) const {
         auto it = m_names.find(entity_id);
         if (it == m_names.end()) {
@@ -162,6 +171,7 @@ private:
 
     std::unordered_map<std::type_index, std::unique_ptr<IComponentPool>> m_pools;
     EntityID m_next_id = 1;  // 0 is for invalid entities
+    uint64_t m_structure_version = 0;
     std::unordered_map<EntityID, std::string> m_names;
     std::vector<EntityID> m_free_ids;
 
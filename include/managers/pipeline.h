@@ -0,0 +1,56 @@
+#pragma once
+
+#include "systems/isystem.h"
+
+#include <tuple>
+#include <type_traits>
+
+struct Engine;
+
+// Compile-time alternative to SystemManager (e.g. for headless servers).
+// Systems are stored by value and run in the order they are listed. Calls are
+// qualified, so there is no virtual dispatch and the frame can be fully inlined.
+//
+//     Pipeline<RigidBodySystem, CollisionDetectionSystem, CollisionResolutionSystem> pipeline;
+//     pipeline.init_all(engine);
+//     pipeline.update_all(engine);
+template <typename... Systems>
+    requires(std::is_base_of_v<ISystem, Systems> && ...)
+class Pipeline {
+public:
+    template <typename T>
+    T& get() {
+        return std::get<T>(m_systems);
+    }
+
+    // Systems bind their contexts here, once
+    void init_all(Engine& engine) {
+        (init_one(std::get<Systems>(m_systems), engine), ...);
+    }
+
+    void update_all(Engine& engine) {
+        (update_one(std::get<Systems>(m_systems), engine), ...);
+    }
+
+    void shutdown_all(Engine& engine) {
+        (shutdown_one(std::get<Systems>(m_systems), engine), ...);
+    }
+
+private:
+    std::tuple<Systems...> m_systems;
+
+    template <typename T>
+    static void init_one(T& system, Engine& engine) {
+        system.T::init(engine);
+    }
+
+    template <typename T>
+    static void update_one(T& system, Engine& engine) {
+        system.T::update(engine);
+    }
+
+    template <typename T>
+    static void shutdown_one(T& system, Engine& engine) {
+        system.T::shutdown(engine);
+    }
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "physics/broadphase.h"
+
+#define AABB_TREE_NULL 0xFFFFFFFFu
+#define AABB_TREE_FAT_RATIO 0.1f     // fat margin as a fraction of the proxy's extent on each axis
+#define AABB_TREE_FAT_MIN 1e-4f      // floor for the margin of degenerate (flat) boxes
+#define AABB_TREE_FULL_PASS_RATIO 4  // self traversal when more than 1/N of the proxies moved
+
+// Dynamic bounding volume hierarchy. Leaves store a fat AABB enlarged in proportion
+// to the proxy's size, so small and huge colliders coexist without tuning and a leaf
+// is only reinserted when its tight box leaves the fat one. Insertion picks the
+// sibling by surface area cost and rotations keep the tree height-balanced.
+// Pairs are refreshed by querying the moved proxies, or by a tree-vs-tree self
+// traversal when most of the scene moved
+class AabbTreeBroadphase : public IBroadphase {
+public:
+    ProxyID add_proxy(const AABB& aabb, EntityID entity, const ProxyFilter& filter) override;
+    void remove_proxy(ProxyID proxy) override;
+    void move_proxy(ProxyID proxy, const AABB& aabb) override;
+    void update_pairs() override;
+
+    // Forgets which proxies moved without looking for pairs, for trees only queried
+    void forget_moved();
+
+    // Calls fn(proxy) for every proxy whose fat box overlaps `aabb`
+    template <typename F>
+    void query(const AABB& aabb, F&& fn) {
+        m_stack.clear();
+        if (m_root != AABB_TREE_NULL) {
+            m_stack.push_back(m_root);
+        }
+
+        while (!m_stack.empty()) {
+            const Node& n = m_nodes[m_stack.back()];
+            m_stack.pop_back();
+
+            if (!aabb_overlap(n.aabb, aabb)) {
+                continue;
+            }
+
+            if (n.is_leaf()) {
+                fn(n.proxy);
+            } else {
+                m_stack.push_back(n.child1);
+                m_stack.push_back(n.child2);
+            }
+        }
+    }
+
+    uint32_t height() const {
+        return m_root == AABB_TREE_NULL ? 0 : m_nodes[m_root].height;
+    }
+
+private:
+    struct Node {
+        AABB aabb;  // fat for leaves
+        uint32_t parent = AABB_TREE_NULL;  // also links the free list
+        uint32_t child1 = AABB_TREE_NULL;
+        uint32_t child2 = AABB_TREE_NULL;
+        uint32_t height = 0;  // 0 for leaves
+        ProxyID proxy = INVALID_PROXY;
+
+        bool is_leaf() const {
+            return child1 == AABB_TREE_NULL;
+        }
+    };
+
+    std::vector<Node> m_nodes;
+    uint32_t m_root = AABB_TREE_NULL;
+    uint32_t m_free = AABB_TREE_NULL;
+
+    std::vector<uint32_t> m_leaves;  // proxy -> leaf node
+    std::vector<uint8_t> m_moved;    // proxy -> moved since the last update
+    std::vector<ProxyID> m_moved_list;
+    uint32_t m_proxy_count = 0;
+
+    std::vector<uint32_t> m_stack;
+    std::vector<BroadphasePair> m_stale;
+
+    uint32_t alloc_node();
+    void free_node(uint32_t node);
+
+    void insert_leaf(uint32_t leaf);
+    void remove_leaf(uint32_t leaf);
+    uint32_t balance(uint32_t node);
+    void refit(uint32_t node);
+
+    void mark_moved(ProxyID proxy);
+    void query_pairs(ProxyID proxy);
+    void self_pairs();
+};
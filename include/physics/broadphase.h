@@ -0,0 +1,218 @@
+#pragma once
+
+#include "core/types/aabb.h"
+#include "core/types/id.h"
+#include "core/types/layers.h"
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include <utility>
+
+using ProxyID = uint32_t;
+
+#define INVALID_PROXY 0xFFFFFFFFu
+
+// What a proxy may pair with, checked before any AABB math
+struct ProxyFilter {
+    LayerMask layer = 0xFFFFFFFF;
+    LayerMask collides_with = 0xFFFFFFFF;  // already combined with the world's layer matrix
+    bool is_static = false;                // static proxies never pair with each other
+
+    bool operator==(const ProxyFilter&) const = default;
+};
+
+struct BroadphasePair {
+    ProxyID a;  // a < b
+    ProxyID b;
+};
+
+// Overlapping proxy pairs kept across frames, along with what changed since
+// the last update
+class PairSet {
+public:
+    bool add(ProxyID a, ProxyID b) {
+        if (a > b) {
+            std::swap(a, b);
+        }
+
+        auto [it, inserted] = m_index.try_emplace(pair_key(a, b), static_cast<uint32_t>(m_pairs.size()));
+        if (!inserted) {
+            m_stamps[it->second] = m_stamp;
+            return false;
+        }
+
+        m_pairs.push_back(BroadphasePair{a, b});
+        m_stamps.push_back(m_stamp);
+        m_added.push_back(BroadphasePair{a, b});
+        return true;
+    }
+
+    bool remove(ProxyID a, ProxyID b) {
+        auto it = m_index.find(pair_key(a, b));
+        if (it == m_index.end()) {
+            return false;
+        }
+
+        erase_at(it->second);
+        return true;
+    }
+
+    // Removes every pair referencing the proxy
+    void remove_proxy(ProxyID p) {
+        for (size_t i = m_pairs.size(); i-- > 0;) {
+            if (m_pairs[i].a == p || m_pairs[i].b == p) {
+                erase_at(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    bool contains(ProxyID a, ProxyID b) const {
+        return m_index.contains(pair_key(a, b));
+    }
+
+    // For strategies that find all pairs from scratch: add() every pair found
+    // between begin_rebuild() and end_rebuild(), the others get removed
+    void begin_rebuild() {
+        m_stamp++;
+    }
+
+    void end_rebuild() {
+        for (size_t i = m_pairs.size(); i-- > 0;) {
+            if (m_stamps[i] != m_stamp) {
+                erase_at(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    void clear_changes() {
+        m_added.clear();
+        m_removed.clear();
+    }
+
+    void clear() {
+        m_removed.insert(m_removed.end(), m_pairs.begin(), m_pairs.end());
+        m_pairs.clear();
+        m_stamps.clear();
+        m_index.clear();
+    }
+
+    const std::vector<BroadphasePair>& pairs() const {
+        return m_pairs;
+    }
+
+    const std::vector<BroadphasePair>& added() const {
+        return m_added;
+    }
+
+    const std::vector<BroadphasePair>& removed() const {
+        return m_removed;
+    }
+
+private:
+    std::vector<BroadphasePair> m_pairs;
+    std::vector<uint32_t> m_stamps;  // last rebuild each pair was found in
+    std::unordered_map<uint64_t, uint32_t> m_index;
+    std::vector<BroadphasePair> m_added;
+    std::vector<BroadphasePair> m_removed;
+    uint32_t m_stamp = 0;
+
+    // Swap-and-pop
+    void erase_at(uint32_t i) {
+        BroadphasePair p = m_pairs[i];
+        m_removed.push_back(p);
+        m_index.erase(pair_key(p.a, p.b));
+
+        uint32_t last = static_cast<uint32_t>(m_pairs.size() - 1);
+        if (i != last) {
+            m_pairs[i] = m_pairs[last];
+            m_stamps[i] = m_stamps[last];
+            m_index[pair_key(m_pairs[i].a, m_pairs[i].b)] = i;
+        }
+        m_pairs.pop_back();
+        m_stamps.pop_back();
+    }
+};
+
+// Finds potentially colliding pairs from world AABBs. Proxies are created once per
+// collider and moved every frame; update_pairs() brings pairs() up to date
+class IBroadphase {
+public:
+    virtual ~IBroadphase() = default;
+
+    virtual ProxyID add_proxy(const AABB& aabb, EntityID entity, const ProxyFilter& filter) = 0;
+    virtual void remove_proxy(ProxyID proxy) = 0;
+    virtual void move_proxy(ProxyID proxy, const AABB& aabb) = 0;
+    virtual void update_pairs() = 0;
+
+    const PairSet& pairs() const {
+        return m_pairs;
+    }
+
+    // Starts a new frame of added/removed pair changes
+    void clear_pair_changes() {
+        m_pairs.clear_changes();
+    }
+
+    EntityID entity(ProxyID proxy) const {
+        return m_proxies[proxy].entity;
+    }
+
+    const AABB& aabb(ProxyID proxy) const {
+        return m_proxies[proxy].aabb;
+    }
+
+    const ProxyFilter& filter(ProxyID proxy) const {
+        return m_proxies[proxy].filter;
+    }
+
+protected:
+    struct Proxy {
+        AABB aabb;
+        EntityID entity = INVALID_ENTITY;
+        ProxyFilter filter;
+        bool alive = false;
+    };
+
+    PairSet m_pairs;
+    std::vector<Proxy> m_proxies;
+    std::vector<ProxyID> m_free_proxies;
+
+    ProxyID alloc_proxy(const AABB& aabb, EntityID entity, const ProxyFilter& filter) {
+        ProxyID p;
+        if (!m_free_proxies.empty()) {
+            p = m_free_proxies.back();
+            m_free_proxies.pop_back();
+        } else {
+            p = static_cast<ProxyID>(m_proxies.size());
+            m_proxies.emplace_back();
+        }
+
+        m_proxies[p] = Proxy{aabb, entity, filter, true};
+        return p;
+    }
+
+    void free_proxy(ProxyID p) {
+        m_pairs.remove_proxy(p);
+        m_proxies[p].alive = false;
+        m_free_proxies.push_back(p);
+    }
+
+    bool can_pair(ProxyID a, ProxyID b) const {
+        const ProxyFilter& A = m_proxies[a].filter;
+        const ProxyFilter& B = m_proxies[b].filter;
+        return (A.collides_with & B.layer) && (B.collides_with & A.layer) && !(A.is_static && B.is_static);
+    }
+};
+
+enum class BroadphaseType { SAP, AabbTree, Grid };
+
+// SAP suits mostly static or slow scenes, AabbTree colliders of very different sizes
+// and Grid crowds of similar-sized bodies
+std::unique_ptr<IBroadphase> make_broadphase(BroadphaseType type);
+
+inline bool aabb_overlap(const AABB& A, const AABB& B) {
+    return (A.min.x <= B.max.x && A.max.x >= B.min.x) && (A.min.y <= B.max.y && A.max.y >= B.min.y) &&
+           (A.min.z <= B.max.z && A.max.z >= B.min.z);
+}
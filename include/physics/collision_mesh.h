@@ -0,0 +1,137 @@
+#pragma once
+
+#include "core/types/aabb.h"
+#include "physics/broadphase.h"
+
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#define MESH_LEAF_SIZE 4            // triangles per BVH leaf
+#define MESH_STACK_SIZE 64          // traversal stack, the median split keeps the tree far shallower
+#define CONVEX_HULL_DIRECTIONS 256  // directions sampled for the hull's vertices
+
+// Triangle soup in the model's local space with a BVH over it, for static level geometry.
+// Built once per model and shared by every collider using it
+class TriangleMesh {
+public:
+    // Appends a submesh, a triangle list when indices is empty
+    void add(std::span<const glm::vec3> positions, std::span<const uint32_t> indices);
+    void build();
+
+    const AABB& bounds() const {
+        return m_nodes.empty() ? m_empty : m_nodes[0].aabb;
+    }
+
+    uint32_t triangle_count() const {
+        return static_cast<uint32_t>(m_triangles.size());
+    }
+
+    void triangle(uint32_t t, glm::vec3& a, glm::vec3& b, glm::vec3& c) const {
+        a = m_vertices[m_triangles[t].v[0]];
+        b = m_vertices[m_triangles[t].v[1]];
+        c = m_vertices[m_triangles[t].v[2]];
+    }
+
+    // Calls fn(t) for every triangle whose bounds overlap `aabb`, all in local space
+    template <typename F>
+    void query(const AABB& aabb, F&& fn) const;
+
+    // First triangle hit by o + d * t within tmax, in local space (d needs no normalizing)
+    bool raycast(const glm::vec3& o, const glm::vec3& d, float tmax, float& t, uint32_t& tri) const;
+
+private:
+    struct Triangle {
+        uint32_t v[3];
+        AABB aabb;
+    };
+
+    struct Node {
+        AABB aabb;
+        uint32_t first = 0;  // first triangle for leaves, left child otherwise (the right one follows it)
+        uint32_t count = 0;  // 0 for internal nodes
+    };
+
+    std::vector<glm::vec3> m_vertices;
+    std::vector<Triangle> m_triangles;
+    std::vector<Node> m_nodes;
+    AABB m_empty{glm::vec3(0.0f), glm::vec3(0.0f)};
+};
+
+// Convex hull of a point cloud for GJK, kept as its vertices only. They are the points
+// extreme along CONVEX_HULL_DIRECTIONS directions, so the hull is the real one or
+// slightly inside it with finely tessellated rounded parts
+class ConvexHull {
+public:
+    void build(std::span<const glm::vec3> points);
+
+    // Farthest vertex along d, returns its index
+    uint32_t support(const glm::vec3& d) const {
+        uint32_t best = 0;
+        float best_dot = glm::dot(m_vertices[0], d);
+        for (uint32_t i = 1; i < m_vertices.size(); i++) {
+            float dot = glm::dot(m_vertices[i], d);
+            if (dot > best_dot) {
+                best_dot = dot;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    const glm::vec3& vertex(uint32_t i) const {
+        return m_vertices[i];
+    }
+
+    uint32_t vertex_count() const {
+        return static_cast<uint32_t>(m_vertices.size());
+    }
+
+    const AABB& bounds() const {
+        return m_bounds;
+    }
+
+    const glm::vec3& centroid() const {
+        return m_centroid;
+    }
+
+    // Smallest distance from the centroid to the surface, for the inner sphere of swept bodies
+    float inner_radius() const {
+        return m_inner_radius;
+    }
+
+private:
+    std::vector<glm::vec3> m_vertices;
+    AABB m_bounds{glm::vec3(0.0f), glm::vec3(0.0f)};
+    glm::vec3 m_centroid{0.0f};
+    float m_inner_radius = 0.0f;
+};
+
+template <typename F>
+void TriangleMesh::query(const AABB& aabb, F&& fn) const {
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    uint32_t stack[MESH_STACK_SIZE];
+    uint32_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = m_nodes[stack[--top]];
+        if (!aabb_overlap(node.aabb, aabb)) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (uint32_t t = node.first; t < node.first + node.count; t++) {
+                if (aabb_overlap(m_triangles[t].aabb, aabb)) {
+                    fn(t);
+                }
+            }
+        } else {
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "physics/shapes.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+#define GJK_MAX_ITERATIONS 32
+#define GJK_TOLERANCE 1e-5f   // relative progress under which the distance has converged
+#define GJK_EPSILON 1e-12f    // squared distance counted as touching
+#define EPA_MAX_ITERATIONS 64
+#define EPA_MAX_FACES 128
+#define EPA_TOLERANCE 1e-4f
+
+enum class SupportKind { Point, Segment, Triangle, Box, Hull };
+
+// A convex core for GJK given by its support function, rounded by `margin`: spheres are
+// a point, capsules a segment. Keeps pointers to boxes and hulls, which must outlive it
+struct SupportShape {
+    SupportKind kind = SupportKind::Point;
+    glm::vec3 points[3]{};  // the core of points, segments and triangles
+    const WorldOBB* obb = nullptr;
+    const WorldConvex* convex = nullptr;
+    float margin = 0.0f;
+
+    SupportShape() = default;
+
+    explicit SupportShape(const WorldSphere& s) : kind(SupportKind::Point), margin(s.radius) {
+        points[0] = s.center;
+    }
+
+    explicit SupportShape(const WorldCapsule& c) : kind(SupportKind::Segment), margin(c.radius) {
+        points[0] = c.p0;
+        points[1] = c.p1;
+    }
+
+    explicit SupportShape(const WorldOBB& o) : kind(SupportKind::Box), obb(&o) {
+    }
+
+    explicit SupportShape(const WorldConvex& c) : kind(SupportKind::Hull), convex(&c) {
+    }
+
+    static SupportShape triangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+        SupportShape s;
+        s.kind = SupportKind::Triangle;
+        s.points[0] = a;
+        s.points[1] = b;
+        s.points[2] = c;
+        return s;
+    }
+
+    // Farthest core vertex along d and an index that gives it back through vertex()
+    glm::vec3 support(const glm::vec3& d, uint32_t& index) const;
+    glm::vec3 vertex(uint32_t index) const;
+    uint32_t vertex_count() const;
+    glm::vec3 center() const;
+};
+
+// Indices of the final simplex of a pair, to start next frame's GJK from it
+struct GjkCache {
+    uint32_t count = 0;
+    uint32_t a[4];
+    uint32_t b[4];
+};
+
+struct GjkVertex {
+    glm::vec3 w;  // a - b, on the Minkowski difference
+    glm::vec3 a;
+    glm::vec3 b;
+    uint32_t ia;
+    uint32_t ib;
+};
+
+struct GjkSimplex {
+    GjkVertex v[4];
+    float weights[4];
+    uint32_t count = 0;
+};
+
+// Distance between the cores of A and B and their closest points. Returns false when
+// the cores overlap, `simplex` then encloses the origin for epa_penetration().
+// Starts from and updates `cache` when given one
+bool gjk_distance(const SupportShape& A, const SupportShape& B, GjkSimplex& simplex, float& distance,
+                  glm::vec3& pa, glm::vec3& pb, GjkCache* cache = nullptr);
+
+// Penetration of overlapping cores along `normal`, which points from A to B, with the
+// deepest points of each. False when the Minkowski difference is flat
+bool epa_penetration(const SupportShape& A, const SupportShape& B, const GjkSimplex& simplex, glm::vec3& normal,
+                     float& depth, glm::vec3& pa, glm::vec3& pb);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "physics/broadphase.h"
+
+#define GRID_AUTO_CELL_SCALE 2.0f       // auto cell size as a multiple of the mean proxy extent
+#define GRID_MAX_CELLS_PER_PROXY 64     // larger proxies are tested against every other one instead
+#define GRID_PARALLEL_GRAIN 256
+
+// Uniform spatial hash grid rebuilt from scratch every update. Each proxy is inserted
+// in the cells its AABB overlaps, and a pair is reported only by the cell holding
+// the min corner of the two boxes' intersection, so it is found once without a
+// dedup pass. Both the insertion and the per-cell pair search run in parallel.
+// Best for many bodies of similar size, the cell size is fixed or derived from
+// the mean proxy extent when 0
+class GridBroadphase : public IBroadphase {
+public:
+    explicit GridBroadphase(float cell_size = 0.0f) : m_fixed_cell_size(cell_size) {
+    }
+
+    ProxyID add_proxy(const AABB& aabb, EntityID entity, const ProxyFilter& filter) override;
+    void remove_proxy(ProxyID proxy) override;
+    void move_proxy(ProxyID proxy, const AABB& aabb) override;
+    void update_pairs() override;
+
+    float cell_size() const {
+        return m_cell_size;
+    }
+
+private:
+    float m_fixed_cell_size;
+    float m_cell_size = 1.0f;
+
+    std::vector<uint64_t> m_cells;             // cell hash << 32 | proxy, sorted
+    std::vector<uint32_t> m_runs;              // start of every cell in m_cells, plus the end
+    std::vector<ProxyID> m_oversized;          // proxies spanning too many cells, sorted
+
+    struct ChunkCells {
+        std::vector<uint64_t> cells;
+        std::vector<ProxyID> oversized;
+    };
+
+    std::vector<ChunkCells> m_chunk_cells;
+    std::vector<std::vector<BroadphasePair>> m_chunk_pairs;
+
+    float compute_cell_size() const;
+    glm::ivec3 cell_of(const glm::vec3& p) const;
+};
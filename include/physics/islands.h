@@ -0,0 +1,42 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+// Bodies split into groups connected by contacts, by union-find. Bodies that don't
+// move under impulses shouldn't be linked, or everything resting on the ground would
+// end up in one island
+class Islands {
+public:
+    // Starts over with `count` bodies, each one its own island
+    void reset(uint32_t count);
+
+    void link(uint32_t a, uint32_t b);
+
+    // Groups the bodies by island, call once everything is linked
+    void build();
+
+    uint32_t island_count() const {
+        return static_cast<uint32_t>(m_offsets.size()) - 1;
+    }
+
+    uint32_t island_of(uint32_t body) const {
+        return m_island[body];
+    }
+
+    std::span<const uint32_t> bodies(uint32_t island) const {
+        return std::span<const uint32_t>(m_bodies).subspan(m_offsets[island], m_offsets[island + 1] - m_offsets[island]);
+    }
+
+private:
+    std::vector<uint32_t> m_parent;
+    std::vector<uint32_t> m_size;
+
+    std::vector<uint32_t> m_island;   // body -> island
+    std::vector<uint32_t> m_bodies;   // bodies sorted by island
+    std::vector<uint32_t> m_offsets;  // island -> its first body in m_bodies, one past the last at the end
+    std::vector<uint32_t> m_scratch;
+
+    uint32_t find(uint32_t i);
+};
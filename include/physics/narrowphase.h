@@ -0,0 +1,83 @@
+#pragma once
+
+#include "core/types/contact.h"
+#include "core/types/id.h"
+#include "physics/gjk.h"
+#include "physics/shapes.h"
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#define COL_EPS 1e-6f
+#define CAPSULE_OBB_ITERATIONS 20  // bisection steps for the capsule segment point closest to a box
+#define MESH_NORMAL_COS 0.95f      // triangle contacts with normals this close share a manifold
+#define MESH_FACE_COS 0.98f        // a contact normal this close to the triangle's is a face contact
+#define MESH_MAX_CONTACTS 4        // manifolds per shape-mesh pair
+#define OBB_NO_AXIS 0xFF           // no axis separates the boxes
+
+bool sphere_vs_sphere(EntityID a, const WorldSphere& A, EntityID b, const WorldSphere& B, Contact& out);
+bool sphere_vs_obb(EntityID a, const WorldSphere& s, EntityID b, const WorldOBB& obb, Contact& out);
+bool obb_vs_obb(EntityID a, const WorldOBB& A, EntityID b, const WorldOBB& B, Contact& out);
+
+// Whether a single axis of obb_vs_obb() separates the boxes, numbered as it tests them:
+// 0-2 faces of A, 3-5 faces of B, 6-14 edge pairs. Agrees with it up to rounding
+bool obb_axis_separates(const WorldOBB& A, const WorldOBB& B, uint32_t axis);
+
+// Capsules are spheres swept along a segment: every test finds the closest points of
+// the cores and treats them as two spheres
+bool sphere_vs_capsule(EntityID a, const WorldSphere& s, EntityID b, const WorldCapsule& cap, Contact& out);
+bool capsule_vs_capsule(EntityID a, const WorldCapsule& A, EntityID b, const WorldCapsule& B, Contact& out);
+bool capsule_vs_obb(EntityID a, const WorldCapsule& cap, EntityID b, const WorldOBB& obb, Contact& out);
+
+// Convex hulls, and anything against them, go through GJK on the shapes' cores and EPA
+// when the cores overlap. The contact is the single deepest point
+bool convex_contact(EntityID a, const SupportShape& A, EntityID b, const SupportShape& B, Contact& out,
+                    GjkCache* cache = nullptr);
+bool convex_overlap(const SupportShape& A, const SupportShape& B);
+
+struct MeshContactPoint {
+    glm::vec3 normal;
+    ContactPoint point;
+    uint32_t manifold;
+};
+
+// Reused across calls to keep the mesh tests allocation free, one per thread
+struct MeshScratch {
+    std::vector<MeshContactPoint> points;
+    std::vector<ContactPoint> manifold;
+};
+
+// Shape against the mesh triangles under its world AABB, found through the mesh's BVH.
+// Triangle contacts with similar normals share a manifold, appends up to MESH_MAX_CONTACTS
+// of them to `out` and returns how many
+uint32_t shape_vs_mesh(EntityID a, const SupportShape& A, const AABB& a_aabb, EntityID b, const WorldMesh& mesh,
+                       std::vector<Contact>& out, MeshScratch& scratch);
+bool shape_overlaps_mesh(const SupportShape& A, const AABB& a_aabb, const WorldMesh& mesh);
+
+// OBB pairs in SoA layout for the batched separating axis test. Runs 8 pairs at a time
+// with AVX, 4 with SSE2 and the rest one by one, and stops after the 6 face axes when
+// every pair of the group is already separated
+class ObbPairBatch {
+public:
+    void clear();
+    void push(const WorldOBB& A, const WorldOBB& B);
+
+    uint32_t size() const {
+        return static_cast<uint32_t>(m_fields[0].size());
+    }
+
+    // axes[i] is the first axis separating pair i in obb_vs_obb()'s order, OBB_NO_AXIS when
+    // none does, the same decision obb_vs_obb() takes. Only those pairs need it for their contact
+    void test(std::vector<uint8_t>& axes) const;
+
+    // Same for pairs [begin, end) only, axes must hold size() entries. Ranges don't
+    // share output so they can be tested on different threads
+    void test(uint32_t begin, uint32_t end, uint8_t* axes) const;
+
+    // Per box: center xyz, half extents xyz, axes[0..2] xyz
+    static constexpr uint32_t BOX_FIELDS = 15;
+
+private:
+    std::array<std::vector<float>, 2 * BOX_FIELDS> m_fields;
+};
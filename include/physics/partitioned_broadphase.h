@@ -0,0 +1,38 @@
+#pragma once
+
+#include "physics/broadphase.h"
+#include "physics/aabb_tree_broadphase.h"
+
+// Keeps static proxies out of the per-frame work. Dynamic proxies go to any strategy,
+// static ones to an AABB tree that only changes when a static collider is added,
+// removed or moved, and is queried by the dynamic proxies that moved. Static-static
+// pairs are never looked at, so a large static level costs next to nothing per frame
+class PartitionedBroadphase : public IBroadphase {
+public:
+    explicit PartitionedBroadphase(std::unique_ptr<IBroadphase> dynamic);
+
+    ProxyID add_proxy(const AABB& aabb, EntityID entity, const ProxyFilter& filter) override;
+    void remove_proxy(ProxyID proxy) override;
+    void move_proxy(ProxyID proxy, const AABB& aabb) override;
+    void update_pairs() override;
+
+    const IBroadphase& dynamic() const {
+        return *m_dynamic;
+    }
+
+private:
+    std::unique_ptr<IBroadphase> m_dynamic;
+    AabbTreeBroadphase m_static;
+
+    std::vector<ProxyID> m_inner;           // proxy -> proxy in m_static or m_dynamic
+    std::vector<ProxyID> m_dynamic_outer;   // m_dynamic proxy -> proxy
+    std::vector<ProxyID> m_static_outer;    // m_static proxy -> proxy
+    std::vector<uint8_t> m_moved;           // dynamic proxy moved since the last update
+    std::vector<ProxyID> m_moved_list;
+    bool m_static_changed = false;          // every dynamic proxy must query the static tree again
+
+    std::vector<BroadphasePair> m_stale;
+
+    void mark_moved(ProxyID proxy);
+    static void map(std::vector<ProxyID>& table, ProxyID from, ProxyID to);
+};
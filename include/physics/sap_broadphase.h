@@ -0,0 +1,40 @@
+#pragma once
+
+#include "physics/broadphase.h"
+
+#include <array>
+
+#define SAP_REBUILD_MIN_ADDS 64
+
+// Incremental sweep-and-prune on all three axes. Endpoint lists stay sorted across
+// frames and are re-sorted with insertion sort, which is close to linear when
+// bodies move little. Every endpoint swap is an overlap begin/end event on that
+// axis, so the pair set is updated without ever testing all pairs
+class SAPBroadphase : public IBroadphase {
+public:
+    ProxyID add_proxy(const AABB& aabb, EntityID entity, const ProxyFilter& filter) override;
+    void remove_proxy(ProxyID proxy) override;
+    void move_proxy(ProxyID proxy, const AABB& aabb) override;
+    void update_pairs() override;
+
+private:
+    struct Endpoint {
+        float value;
+        uint32_t data;  // proxy << 1 | is_max
+
+        ProxyID proxy() const {
+            return data >> 1;
+        }
+
+        bool is_max() const {
+            return data & 1;
+        }
+    };
+
+    std::array<std::vector<Endpoint>, 3> m_axes;
+    std::vector<std::array<uint32_t, 6>> m_endpoint_index;  // per proxy: min x, y, z then max x, y, z
+    uint32_t m_pending_adds = 0;                           // proxies added since the last update
+
+    void sort_axis(uint32_t axis);
+    void rebuild();
+};
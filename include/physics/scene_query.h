@@ -0,0 +1,138 @@
+#pragma once
+
+#include "core/types/aabb.h"
+#include "core/types/id.h"
+#include "core/types/layers.h"
+#include "physics/shapes.h"
+#include "physics/shape_cast.h"
+
+#include <glm/glm.hpp>
+#include <cfloat>
+#include <span>
+#include <variant>
+#include <vector>
+#include <cstdint>
+
+#define SQ_LEAF_SIZE 4             // shapes per BVH leaf
+#define SQ_STACK_SIZE 64           // traversal stack, the median split keeps the tree far shallower
+#define SQ_PACKET_SIZE 4           // rays traversed together by raycast_batch(), one SSE register
+#define SQ_PARALLEL_GRAIN 16       // packets per thread pool chunk
+
+struct Ray {
+    glm::vec3 origin{0.0f};
+    glm::vec3 direction{0.0f, 0.0f, -1.0f};  // normalized by the queries
+    float max_distance = FLT_MAX;
+};
+
+// Closest: the nearest result only. Any: the first one found, cheapest, e.g. for line
+// of sight. All: every result, sorted by distance for casts
+enum class QueryMode { Closest, Any, All };
+
+struct QueryFilter {
+    LayerMask layers = 0xFFFFFFFF;
+    bool include_triggers = false;
+    EntityID ignore = INVALID_ENTITY;  // usually the querying entity itself
+};
+
+// Results of raycast_batch(): the hits of ray i are hits[offsets[i]] to hits[offsets[i + 1]]
+struct RayBatchHits {
+    std::vector<RayHit> hits;
+    std::vector<uint32_t> offsets;
+};
+
+// Ray, shape cast and overlap queries against the world's colliders. The collision
+// detection system keeps one shape per collider in the slot of its entry, and only sets
+// it again when the collider moves. The BVH over them is rebuilt on the first query after
+// shapes were added or removed, and refit after they only moved. Queries are meant to
+// come from one thread at a time, batches are split across the thread pool internally
+class SceneQuery {
+public:
+    void clear();
+
+    // Adds the shape in `slot`, or moves the one already there
+    void set(uint32_t slot, EntityID entity, const WorldSphere& sphere, LayerMask layer, bool is_trigger);
+    void set(uint32_t slot, EntityID entity, const WorldOBB& obb, LayerMask layer, bool is_trigger);
+    void set(uint32_t slot, EntityID entity, const WorldCapsule& capsule, LayerMask layer, bool is_trigger);
+    void set(uint32_t slot, EntityID entity, const WorldConvex& convex, LayerMask layer, bool is_trigger);
+    void set(uint32_t slot, EntityID entity, const WorldMesh& mesh, LayerMask layer, bool is_trigger);
+
+    // What filters see of the shape in `slot`, changing it leaves the BVH alone
+    void set_filter(uint32_t slot, LayerMask layer, bool is_trigger);
+    void remove(uint32_t slot);
+
+    // Each returns the number of results appended
+    uint32_t raycast(const Ray& ray, QueryMode mode, std::vector<RayHit>& hits, const QueryFilter& filter = {});
+    uint32_t sphere_cast(const Ray& ray, float radius, QueryMode mode, std::vector<RayHit>& hits,
+                         const QueryFilter& filter = {});
+    uint32_t overlap_sphere(const WorldSphere& sphere, QueryMode mode, std::vector<EntityID>& entities,
+                            const QueryFilter& filter = {});
+    uint32_t overlap_box(const WorldOBB& obb, QueryMode mode, std::vector<EntityID>& entities,
+                         const QueryFilter& filter = {});
+
+    // Traces rays in SIMD packets of consecutive rays, so coherent rays (e.g. from the
+    // same origin) share most of the traversal
+    void raycast_batch(std::span<const Ray> rays, QueryMode mode, RayBatchHits& out, const QueryFilter& filter = {});
+
+    uint32_t size() const {
+        return m_count;
+    }
+
+private:
+    // One world shape, its kind given by `type`. Free slots have no entity
+    struct Shape {
+        AABB aabb;
+        std::variant<WorldOBB, WorldSphere, WorldCapsule, WorldConvex, WorldMesh> shape;
+        EntityID entity = INVALID_ENTITY;
+        LayerMask layer = 0;
+        ColliderType type = ColliderType::OBB;
+        bool is_trigger = false;
+    };
+
+    struct Node {
+        AABB aabb;
+        uint32_t first = 0;  // first of m_order for leaves, left child otherwise (the right one follows it)
+        uint32_t count = 0;  // 0 for internal nodes
+        uint32_t axis = 0;   // split axis, to visit the nearer child first
+    };
+
+    // Hit of one lane of a packet, for QueryMode::All
+    struct LaneHit {
+        uint32_t lane;
+        RayHit hit;
+    };
+
+    struct ChunkHits {
+        std::vector<RayHit> hits;
+        std::vector<LaneHit> scratch;
+    };
+
+    std::vector<Shape> m_shapes;  // by slot
+    std::vector<uint32_t> m_order;  // slots of the shapes in the BVH, leaf by leaf
+    std::vector<Node> m_nodes;
+    uint32_t m_count = 0;
+    bool m_dirty = false;  // shapes were added or removed since the last build
+    bool m_moved = false;  // shapes moved since the last build or refit
+
+    std::vector<LaneHit> m_scratch;
+    std::vector<ChunkHits> m_chunk_hits;
+    std::vector<uint32_t> m_counts;
+
+    template <typename T>
+    void set_shape(uint32_t slot, EntityID entity, const T& shape, const AABB& aabb, ColliderType type, LayerMask layer,
+                   bool is_trigger);
+    void update();
+    void build();
+    void refit();
+    bool accepts(const Shape& s, const QueryFilter& filter) const;
+    static glm::vec3 shape_center(const Shape& s);
+    static bool cast(const Shape& s, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit);
+
+    // Traces up to SQ_PACKET_SIZE rays (swept by `radius` for shape casts) and appends
+    // the results of each ray in order to `out`, its count to counts[lane]
+    void trace(const Ray* rays, uint32_t count, float radius, QueryMode mode, const QueryFilter& filter,
+               std::vector<RayHit>& out, uint32_t* counts, std::vector<LaneHit>& scratch) const;
+
+    template <typename F>
+    uint32_t overlap(const AABB& aabb, F&& test, const glm::vec3& center, QueryMode mode,
+                     std::vector<EntityID>& entities, const QueryFilter& filter);
+};
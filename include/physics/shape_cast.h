@@ -0,0 +1,26 @@
+#pragma once
+
+#include "core/types/id.h"
+#include "physics/shapes.h"
+
+#include <glm/glm.hpp>
+
+#define CAST_MAX_ITERATIONS 32  // conservative advancement steps against boxes, hulls and mesh triangles
+#define CAST_TOLERANCE 1e-4f
+
+struct RayHit {
+    EntityID entity = INVALID_ENTITY;
+    float distance = 0.0f;   // along the ray, 0 when it starts inside the shape
+    glm::vec3 point{0.0f};   // on the surface of the hit shape
+    glm::vec3 normal{0.0f};  // of that surface, against the ray when it starts inside
+};
+
+// Casts a sphere of `radius` (0 for a ray) from `o` along the unit direction `d` and reports
+// the first touch within `tmax`. Leaves hit.entity to the caller
+bool cast_sphere(const WorldSphere& s, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit);
+bool cast_obb(const WorldOBB& obb, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit);
+bool cast_capsule(const WorldCapsule& cap, const glm::vec3& o, const glm::vec3& d, float radius, float tmax,
+                  RayHit& hit);
+bool cast_convex(const WorldConvex& c, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit);
+// Meshes have no inside, a cast starting within one hits the triangles around it
+bool cast_mesh(const WorldMesh& m, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit);
@@ -0,0 +1,262 @@
+#pragma once
+
+#include "components/transform.h"
+#include "components/collider.h"
+#include "core/types/aabb.h"
+#include "physics/collision_mesh.h"
+
+#include <glm/glm.hpp>
+#include <stdexcept>
+
+struct WorldOBB {
+    glm::vec3 center;
+    glm::vec3 half_extents;  // half extents in world units
+    glm::vec3 axes[3];       // unit axes in world space
+
+    WorldOBB() = default;
+
+    WorldOBB(Transform& tr, Collider& c) {
+        const glm::mat4& M = tr.model_matrix();
+        glm::vec3 x(M[0]);
+        glm::vec3 y(M[1]);
+        glm::vec3 z(M[2]);
+
+        glm::vec4 local_center(c.offset, 1.0f);
+        center = glm::vec3(M * local_center);
+
+        glm::vec3 half_extents_local = c.size * 0.5f;
+        half_extents.x = glm::length(x) * half_extents_local.x;
+        half_extents.y = glm::length(y) * half_extents_local.y;
+        half_extents.z = glm::length(z) * half_extents_local.z;
+
+        axes[0] = glm::normalize(x);
+        axes[1] = glm::normalize(y);
+        axes[2] = glm::normalize(z);
+    }
+};
+
+struct WorldSphere {
+    glm::vec3 center;
+    float radius;
+
+    WorldSphere() = default;
+
+    WorldSphere(Transform& tr, Collider& c) {
+        const glm::mat4& M = tr.model_matrix();
+
+        glm::vec4 local_center(c.offset, 1.0f);
+        center = (M * local_center);
+
+        float sx = glm::length(glm::vec3(M[0]));
+        float sy = glm::length(glm::vec3(M[1]));
+        float sz = glm::length(glm::vec3(M[2]));
+        float max_scale = glm::max(sx, glm::max(sy, sz));
+
+        radius = c.size.x * max_scale;
+    }
+};
+
+struct WorldCapsule {
+    glm::vec3 p0;  // bottom center point
+    glm::vec3 p1;  // top center point
+    float radius;  // radius of the capsule
+
+    WorldCapsule() = default;
+
+    WorldCapsule(Transform& tr, Collider& c) {
+        const glm::mat4& M = tr.model_matrix();
+
+        glm::vec4 local_center(c.offset, 1.0f);
+        glm::vec3 center(M * local_center);
+
+        glm::vec3 up = glm::normalize(glm::vec3(M[1]));  // Y axis in world space
+        float sx = glm::length(glm::vec3(M[0]));
+        float sy = glm::length(glm::vec3(M[1]));
+
+        float hh = (c.size.y * 0.5f) * sy;  // half height
+
+        p0 = center - up * hh;
+        p1 = center + up * hh;
+        radius = c.size.x * sx;
+    }
+};
+
+// Hull in model space under the model matrix, scale included
+struct WorldConvex {
+    const ConvexHull* hull = nullptr;
+    glm::mat3 basis{1.0f};
+    glm::vec3 origin{0.0f};
+
+    WorldConvex() = default;
+
+    WorldConvex(Transform& tr, Collider& c) {
+        if (!c.hull) {
+            throw std::runtime_error("[WorldConvex] Convex collider without a hull!");
+        }
+
+        const glm::mat4& M = tr.model_matrix();
+        hull = c.hull.get();
+        basis = glm::mat3(M);
+        origin = glm::vec3(M[3]);
+    }
+
+    glm::vec3 vertex(uint32_t i) const {
+        return basis * hull->vertex(i) + origin;
+    }
+
+    // Farthest vertex along the world direction d, its index in `index`
+    glm::vec3 support(const glm::vec3& d, uint32_t& index) const {
+        index = hull->support(glm::transpose(basis) * d);
+        return vertex(index);
+    }
+};
+
+// Static triangle mesh in model space, queried in it through the inverse model matrix
+struct WorldMesh {
+    const TriangleMesh* mesh = nullptr;
+    glm::mat4 transform{1.0f};
+    glm::mat4 inverse{1.0f};
+
+    WorldMesh() = default;
+
+    WorldMesh(Transform& tr, Collider& c) {
+        if (!c.mesh) {
+            throw std::runtime_error("[WorldMesh] Mesh collider without a mesh!");
+        }
+
+        mesh = c.mesh.get();
+        transform = tr.model_matrix();
+        inverse = glm::inverse(transform);
+    }
+
+    void triangle(uint32_t t, glm::vec3& a, glm::vec3& b, glm::vec3& c) const {
+        mesh->triangle(t, a, b, c);
+        a = glm::vec3(transform * glm::vec4(a, 1.0f));
+        b = glm::vec3(transform * glm::vec4(b, 1.0f));
+        c = glm::vec3(transform * glm::vec4(c, 1.0f));
+    }
+};
+
+// Bounds of a box under an affine map
+inline AABB transform_aabb(const AABB& box, const glm::mat3& basis, const glm::vec3& origin) {
+    glm::vec3 center = basis * ((box.min + box.max) * 0.5f) + origin;
+    glm::vec3 half = (box.max - box.min) * 0.5f;
+    glm::vec3 extents = glm::abs(basis[0]) * half.x + glm::abs(basis[1]) * half.y + glm::abs(basis[2]) * half.z;
+    return AABB{.min = center - extents, .max = center + extents};
+}
+
+inline AABB compute_world_aabb_from_convex(const WorldConvex& c) {
+    return transform_aabb(c.hull->bounds(), c.basis, c.origin);
+}
+
+inline AABB compute_world_aabb_from_mesh(const WorldMesh& m) {
+    return transform_aabb(m.mesh->bounds(), glm::mat3(m.transform), glm::vec3(m.transform[3]));
+}
+
+inline AABB compute_world_aabb_from_sphere(const WorldSphere& s) {
+    glm::vec3 radius_vec(s.radius);
+    return AABB{.min = s.center - radius_vec, .max = s.center + radius_vec};
+}
+
+inline AABB compute_world_aabb_from_capsule(const WorldCapsule& c) {
+    glm::vec3 radius_vec(c.radius);
+    return AABB{.min = glm::min(c.p0, c.p1) - radius_vec, .max = glm::max(c.p0, c.p1) + radius_vec};
+}
+
+inline AABB compute_world_aabb_from_obb(const WorldOBB& obb) {
+    glm::vec3 e0 = glm::abs(obb.axes[0]) * obb.half_extents.x;
+    glm::vec3 e1 = glm::abs(obb.axes[1]) * obb.half_extents.y;
+    glm::vec3 e2 = glm::abs(obb.axes[2]) * obb.half_extents.z;
+
+    glm::vec3 extents = e0 + e1 + e2;
+
+    return AABB{.min = obb.center - extents, .max = obb.center + extents};
+}
+
+inline glm::vec3 closest_point_on_segment(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& q) {
+    glm::vec3 d = p1 - p0;
+    float len2 = glm::dot(d, d);
+    float t = len2 > 0.0f ? glm::clamp(glm::dot(q - p0, d) / len2, 0.0f, 1.0f) : 0.0f;
+    return p0 + d * t;
+}
+
+inline glm::vec3 closest_point_on_obb(const WorldOBB& obb, const glm::vec3& p) {
+    glm::vec3 rel = p - obb.center;
+    glm::vec3 q = obb.center;
+    for (uint32_t k = 0; k < 3; k++) {
+        q += obb.axes[k] * glm::clamp(glm::dot(rel, obb.axes[k]), -obb.half_extents[k], obb.half_extents[k]);
+    }
+    return q;
+}
+
+// Closest point of triangle abc to q and its barycentric weights (Ericson, Real-Time
+// Collision Detection 5.1.5)
+inline glm::vec3 closest_point_on_triangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
+                                           const glm::vec3& q, float weights[3]) {
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 aq = q - a;
+    float d1 = glm::dot(ab, aq);
+    float d2 = glm::dot(ac, aq);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        weights[0] = 1.0f;
+        weights[1] = 0.0f;
+        weights[2] = 0.0f;
+        return a;
+    }
+
+    glm::vec3 bq = q - b;
+    float d3 = glm::dot(ab, bq);
+    float d4 = glm::dot(ac, bq);
+    if (d3 >= 0.0f && d4 <= d3) {
+        weights[0] = 0.0f;
+        weights[1] = 1.0f;
+        weights[2] = 0.0f;
+        return b;
+    }
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        float v = d1 / (d1 - d3);
+        weights[0] = 1.0f - v;
+        weights[1] = v;
+        weights[2] = 0.0f;
+        return a + ab * v;
+    }
+
+    glm::vec3 cq = q - c;
+    float d5 = glm::dot(ab, cq);
+    float d6 = glm::dot(ac, cq);
+    if (d6 >= 0.0f && d5 <= d6) {
+        weights[0] = 0.0f;
+        weights[1] = 0.0f;
+        weights[2] = 1.0f;
+        return c;
+    }
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        float w = d2 / (d2 - d6);
+        weights[0] = 1.0f - w;
+        weights[1] = 0.0f;
+        weights[2] = w;
+        return a + ac * w;
+    }
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        weights[0] = 0.0f;
+        weights[1] = 1.0f - w;
+        weights[2] = w;
+        return b + (c - b) * w;
+    }
+
+    float denom = 1.0f / (va + vb + vc);
+    float v = vb * denom;
+    float w = vc * denom;
+    weights[0] = 1.0f - v - w;
+    weights[1] = v;
+    weights[2] = w;
+    return a + ab * v + ac * w;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define SIMD_HAS_SSE2
+#endif
+
+// Lane types for batched kernels: a float per item plus the comparison mask type.
+// Kernels are templates over them and run the widest one available, then F32x1 for
+// the items left over
+
+struct F32x1 {
+    float v;
+
+    static constexpr uint32_t WIDTH = 1;
+    using Mask = bool;
+
+    static F32x1 load(const float* p) {
+        return {*p};
+    }
+    static F32x1 set(float x) {
+        return {x};
+    }
+    void store(float* p) const {
+        *p = v;
+    }
+
+    friend F32x1 operator+(F32x1 a, F32x1 b) {
+        return {a.v + b.v};
+    }
+    friend F32x1 operator-(F32x1 a, F32x1 b) {
+        return {a.v - b.v};
+    }
+    friend F32x1 operator*(F32x1 a, F32x1 b) {
+        return {a.v * b.v};
+    }
+    friend F32x1 operator/(F32x1 a, F32x1 b) {
+        return {a.v / b.v};
+    }
+
+    static F32x1 abs(F32x1 a) {
+        return {std::abs(a.v)};
+    }
+    static F32x1 sqrt(F32x1 a) {
+        return {std::sqrt(a.v)};
+    }
+    static Mask lt(F32x1 a, F32x1 b) {
+        return a.v < b.v;
+    }
+    static Mask mask_andnot(Mask a, Mask b) {
+        return !a && b;
+    }
+    static F32x1 select(Mask m, F32x1 a, F32x1 b) {
+        return {m ? a.v : b.v};
+    }
+    static uint32_t bits(Mask m) {
+        return m ? 1u : 0u;
+    }
+};
+
+#ifdef SIMD_HAS_SSE2
+struct F32x4 {
+    __m128 v;
+
+    static constexpr uint32_t WIDTH = 4;
+    using Mask = __m128;
+
+    static F32x4 load(const float* p) {
+        return {_mm_loadu_ps(p)};
+    }
+    static F32x4 set(float x) {
+        return {_mm_set1_ps(x)};
+    }
+    void store(float* p) const {
+        _mm_storeu_ps(p, v);
+    }
+
+    friend F32x4 operator+(F32x4 a, F32x4 b) {
+        return {_mm_add_ps(a.v, b.v)};
+    }
+    friend F32x4 operator-(F32x4 a, F32x4 b) {
+        return {_mm_sub_ps(a.v, b.v)};
+    }
+    friend F32x4 operator*(F32x4 a, F32x4 b) {
+        return {_mm_mul_ps(a.v, b.v)};
+    }
+    friend F32x4 operator/(F32x4 a, F32x4 b) {
+        return {_mm_div_ps(a.v, b.v)};
+    }
+
+    static F32x4 abs(F32x4 a) {
+        return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)};
+    }
+    static F32x4 sqrt(F32x4 a) {
+        return {_mm_sqrt_ps(a.v)};
+    }
+    static Mask lt(F32x4 a, F32x4 b) {
+        return _mm_cmplt_ps(a.v, b.v);
+    }
+    static Mask mask_andnot(Mask a, Mask b) {
+        return _mm_andnot_ps(a, b);
+    }
+    static F32x4 select(Mask m, F32x4 a, F32x4 b) {
+        return {_mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v))};
+    }
+    static uint32_t bits(Mask m) {
+        return static_cast<uint32_t>(_mm_movemask_ps(m));
+    }
+};
+#endif
+
+#ifdef __AVX__
+struct F32x8 {
+    __m256 v;
+
+    static constexpr uint32_t WIDTH = 8;
+    using Mask = __m256;
+
+    static F32x8 load(const float* p) {
+        return {_mm256_loadu_ps(p)};
+    }
+    static F32x8 set(float x) {
+        return {_mm256_set1_ps(x)};
+    }
+    void store(float* p) const {
+        _mm256_storeu_ps(p, v);
+    }
+
+    friend F32x8 operator+(F32x8 a, F32x8 b) {
+        return {_mm256_add_ps(a.v, b.v)};
+    }
+    friend F32x8 operator-(F32x8 a, F32x8 b) {
+        return {_mm256_sub_ps(a.v, b.v)};
+    }
+    friend F32x8 operator*(F32x8 a, F32x8 b) {
+        return {_mm256_mul_ps(a.v, b.v)};
+    }
+    friend F32x8 operator/(F32x8 a, F32x8 b) {
+        return {_mm256_div_ps(a.v, b.v)};
+    }
+
+    static F32x8 abs(F32x8 a) {
+        return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)};
+    }
+    static F32x8 sqrt(F32x8 a) {
+        return {_mm256_sqrt_ps(a.v)};
+    }
+    static Mask lt(F32x8 a, F32x8 b) {
+        return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ);
+    }
+    static Mask mask_andnot(Mask a, Mask b) {
+        return _mm256_andnot_ps(a, b);
+    }
+    static F32x8 select(Mask m, F32x8 a, F32x8 b) {
+        return {_mm256_blendv_ps(b.v, a.v, m)};
+    }
+    static uint32_t bits(Mask m) {
+        return static_cast<uint32_t>(_mm256_movemask_ps(m));
+    }
+};
+#endif
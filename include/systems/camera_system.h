@@ -1,8 +1,16 @@
 #pragma once
 
 #include "systems/isystem.h"
+#include "contexts/contexts.h"
+#include "contexts/context_ref.h"
 
 class CameraSystem : public ISystem {
 public:
+    using Contexts = ContextAccess<const CameraContext>;
+
+    void init(Engine& engine) override;
     void update(Engine& engine) override;
+
+private:
+    ContextRef<const CameraContext> m_cc;
 };
\ No newline at end of file
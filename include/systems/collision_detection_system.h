@@ -1,9 +1,93 @@
 #pragma once
 
 #include "systems/isystem.h"
+#include "contexts/contexts.h"
+#include "contexts/context_ref.h"
+#include "core/types/id.h"
+#include "physics/broadphase.h"
+#include "physics/narrowphase.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct CollisionEntry;
+struct Collider;
 
 class CollisionDetectionSystem : public ISystem {
 public:
+    using Contexts = ContextAccess<CollisionContext>;
+
+    CollisionDetectionSystem();
+    ~CollisionDetectionSystem() override;
+
     void init(Engine& engine) override;
     void update(Engine& engine) override;
+
+private:
+    ContextRef<CollisionContext> m_cc;
+
+    struct ProxyState {
+        ProxyID proxy = INVALID_PROXY;
+        ProxyFilter filter;
+        uint32_t entry = 0;  // slot of the collider in m_entries, kept while the proxy lives
+        uint64_t frame = 0;  // last frame the collider was seen
+    };
+
+    uint64_t m_broadphase_generation = UINT64_MAX;  // the proxies below belong to that broadphase
+    std::unordered_map<EntityID, ProxyState> m_proxies;
+    std::vector<uint32_t> m_proxy_entries;  // proxy -> entry
+
+    // World shapes of the colliders, recomputed only when their transform or shape changes
+    std::vector<CollisionEntry> m_entries;
+    std::vector<uint32_t> m_free_entries;
+    uint64_t m_frame = 0;
+
+    // Last frame's contacts by pair, to carry accumulated impulses over
+    std::vector<Contact> m_prev_contacts;
+    std::unordered_map<uint64_t, uint32_t> m_prev_index;
+
+    // Collision geometry built from models, shared by every collider of the same model
+    std::unordered_map<AssetID, std::shared_ptr<const ConvexHull>> m_hulls;
+    std::unordered_map<AssetID, std::shared_ptr<const TriangleMesh>> m_meshes;
+    std::vector<glm::vec3> m_hull_points;
+
+    // Last frame's GJK simplex by pair, read only during the narrowphase
+    std::unordered_map<uint64_t, GjkCache> m_gjk_cache;
+
+    // Axis that last separated each OBB pair, by broadphase proxy pair
+    std::unordered_map<uint64_t, uint8_t> m_separating_axes;
+
+    ObbPairBatch m_obb_batch;
+    std::vector<uint32_t> m_batch_pairs;  // m_obb_batch -> broadphase pair
+    std::vector<uint8_t> m_batch_axes;
+    std::vector<uint8_t> m_pair_axes;  // broadphase pair -> separating axis, OBB_NO_AXIS if none
+
+    // Narrowphase output per thread pool chunk
+    struct NarrowphaseChunk {
+        std::vector<Contact> contacts;
+        std::vector<std::pair<uint32_t, uint32_t>> ccd_pairs;  // entries with a swept body and no contact
+        std::vector<std::pair<uint64_t, GjkCache>> gjk_caches;
+        MeshScratch mesh_scratch;
+    };
+
+    std::vector<NarrowphaseChunk> m_chunks;
+
+    struct CcdHit {
+        uint32_t entry;  // the swept body
+        float toi;       // fraction of the step
+        glm::vec3 motion;
+        Contact contact;
+    };
+
+    std::vector<CcdHit> m_ccd_hits;
+    std::vector<EntityID> m_rewound;  // bodies sweep_ccd moved back this frame, sorted
+
+    void build_geometry(Engine& engine, EntityID e, Collider& col);
+    void keep_contacts(uint64_t key, NarrowphaseChunk& out) const;
+    void warm_start(Contact& c) const;
+    void track_pairs(CollisionContext& cc) const;
+    void sweep_ccd(uint32_t chunks, CollisionContext& cc);
 };
@@ -1,15 +1,105 @@
 #pragma once
 
 #include "systems/isystem.h"
+#include "contexts/contexts.h"
+#include "contexts/context_ref.h"
+#include "core/types/id.h"
+#include "physics/islands.h"
+
+#include <glm/glm.hpp>
+#include <vector>
 
 class EntityManager;
-class Contact;
+struct Contact;
+struct ContactPoint;
+struct RigidBody;
+struct Transform;
+struct FPController;
 
 class CollisionResolutionSystem : public ISystem {
 public:
+    using Contexts = ContextAccess<CollisionContext, EventContext, const PhysicsContext>;
+
+    void init(Engine& engine) override;
     void update(Engine& engine) override;
 
 private:
-    void resolve_phys_contact(EntityManager& em, const Contact& c);
-    void positional_correction(EntityManager& em, const Contact& c);
+    ContextRef<CollisionContext> m_cc;
+    ContextRef<EventContext> m_ec;
+    ContextRef<const PhysicsContext> m_pc;
+
+    // Bodies gathered once per step, the solver only touches these arrays
+    struct SolverBodies {
+        std::vector<glm::vec3> velocity;
+        std::vector<float> inv_mass;        // 0 for bodies impulses don't move
+        std::vector<glm::vec3> correction;  // positional correction, applied once solved
+        std::vector<RigidBody*> rb;
+        std::vector<Transform*> tr;
+        std::vector<FPController*> controller;  // grounded by contacts from below, may be null
+        std::vector<EntityID> entity;
+    };
+
+    // One row per contact point
+    struct SolverRows {
+        std::vector<uint32_t> a;
+        std::vector<uint32_t> b;
+        std::vector<glm::vec3> normal;
+        std::vector<glm::vec3> t1;
+        std::vector<glm::vec3> t2;
+        std::vector<float> mass;  // effective mass, the same along every direction without rotation
+        std::vector<float> friction;
+        std::vector<float> bounce;  // target separating speed from restitution
+        std::vector<float> normal_impulse;
+        std::vector<glm::vec2> tangent_impulse;
+        std::vector<ContactPoint*> point;
+    };
+
+    SolverBodies m_bodies;
+    SolverRows m_rows;
+    std::vector<uint32_t> m_body_index;  // entity -> body, SOLVER_NO_BODY when it has none
+
+    // Bodies connected through contacts, which sleep and wake together
+    Islands m_islands;
+    std::vector<uint8_t> m_island_awake;
+
+    // Each contact is a unit of consecutive rows, its points. Islands and colors are ranges of units
+    struct SolverIsland {
+        uint32_t first;
+        uint32_t end;
+        uint32_t first_color;  // colors in m_colors, none for islands solved by one thread
+        uint32_t color_count;
+    };
+
+    struct SolverColor {
+        uint32_t first;
+        uint32_t end;
+        bool parallel;  // false for the contacts left over once every color was taken
+    };
+
+    std::vector<uint32_t> m_unit_rows;  // unit -> first row, one past the last at the end
+    std::vector<SolverIsland> m_small_islands;
+    std::vector<SolverIsland> m_large_islands;
+    std::vector<SolverColor> m_colors;
+
+    std::vector<uint32_t> m_order;  // contacts in solving order
+    std::vector<uint32_t> m_contact_island;
+    std::vector<uint32_t> m_island_first;
+    std::vector<uint32_t> m_island_points;
+    std::vector<uint32_t> m_cursor;
+    std::vector<uint64_t> m_body_colors;  // colors taken by each body, while coloring an island
+    std::vector<uint32_t> m_contact_color;
+    std::vector<uint32_t> m_sorted;
+
+    void gather_bodies(EntityManager& em);
+    void link_contact(const Contact& c);
+    void wake_islands(const CollisionContext& cc);
+    uint32_t contact_island(Contact& c) const;
+    void build_rows(std::vector<Contact>& contacts);
+    void color_contacts(const std::vector<Contact>& contacts, uint32_t begin, uint32_t end, uint32_t first_unit);
+    void add_contact(Contact& c);
+    void solve(uint32_t iterations);
+    void warm_start_rows(uint32_t begin, uint32_t end);
+    void solve_rows(uint32_t begin, uint32_t end);
+    void update_sleep(float dt);
+    void scatter();
 };
@@ -1,9 +1,17 @@
 #pragma once
 
 #include "systems/isystem.h"
+#include "contexts/contexts.h"
+#include "contexts/context_ref.h"
 
 class FirstPersonControllerSystem : public ISystem {
 public:
+    using Contexts = ContextAccess<InputContext, EventContext>;
+
     void init(Engine& engine) override;
     void update(Engine& engine) override;
+
+private:
+    ContextRef<InputContext> m_ic;
+    ContextRef<EventContext> m_ec;
 };
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "systems/isystem.h"
+#include "contexts/context_ref.h"
 
 class LightSystem : public ISystem {
 public:
+    using Contexts = ContextAccess<>;
+
     void init(Engine& engine) override;
     void update(Engine& /*engine*/) override {
     }
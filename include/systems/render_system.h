@@ -1,13 +1,12 @@
 #pragma once
 
 #include "systems/isystem.h"
+#include "contexts/contexts.h"
+#include "contexts/context_ref.h"
 
 class EntityManager;
 class AssetManager;
 class Camera;
-class RenderContext;
-class DebugContext;
-class InputContext;
 
 #include <glm/glm.hpp>
 #include <unordered_map>
@@ -15,10 +14,17 @@ class InputContext;
 
 class RenderSystem : public ISystem {
 public:
+    using Contexts = ContextAccess<RenderContext, const CameraContext, DebugContext, InputContext>;
+
     void init(Engine& engine) override;
     void update(Engine& engine) override;
 
 private:
+    ContextRef<RenderContext> m_rc;
+    ContextRef<const CameraContext> m_cc;
+    ContextRef<DebugContext> m_dc;
+    ContextRef<InputContext> m_ic;
+
     void render_scene(EntityManager& em, AssetManager& am, Camera& cam_c, DebugContext& dc);
     void render_debug(EntityManager& em, AssetManager& am, Camera& cam_c, DebugContext& dc);
     void render_gui(EntityManager& em, RenderContext& rc, DebugContext& dc);
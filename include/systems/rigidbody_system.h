@@ -1,12 +1,53 @@
 #pragma once
 
 #include "systems/isystem.h"
+#include "contexts/contexts.h"
+#include "contexts/context_ref.h"
 
 #include <glm/glm.hpp>
+#include <array>
+#include <utility>
 #include <vector>
+#include <cstdint>
+
+class EntityManager;
+struct RigidBody;
+struct Transform;
+struct FPController;
+struct Camera;
 
 class RigidBodySystem : public ISystem {
 public:
+    using Contexts = ContextAccess<const PhysicsContext, EventContext>;
+
+    static constexpr uint32_t BODY_FIELDS = 15;
+
     void init(Engine& engine) override;
     void update(Engine& engine) override;
-};
\ No newline at end of file
+
+private:
+    ContextRef<const PhysicsContext> m_pc;
+    ContextRef<EventContext> m_ec;
+
+    // Bodies packed every step for the integration kernel, an array per field
+    std::array<std::vector<float>, BODY_FIELDS> m_fields;
+
+    // Components of the bodies, looked up again only when the entity manager's structure changes
+    std::vector<RigidBody*> m_rbs;
+    std::vector<Transform*> m_trs;
+    std::vector<std::pair<uint32_t, FPController*>> m_controllers;  // body, its controller
+    std::vector<uint32_t> m_body_index;                             // entity -> body, while collecting
+    uint64_t m_structure_version = UINT64_MAX;
+
+    // What levels of detail are measured from
+    std::vector<Camera*> m_cameras;
+    std::vector<Transform*> m_listeners;
+    std::vector<glm::vec3> m_observers;
+    uint64_t m_frame = 0;
+
+    void collect(EntityManager& em);
+    void gather(const PhysicsContext& pc);
+    uint8_t lod_level(const PhysicsContext& pc, const glm::vec3& position);
+    void integrate(const glm::vec3& gravity);
+    void scatter();
+};
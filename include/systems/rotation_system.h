@@ -1,8 +1,16 @@
 #pragma once
 
 #include "systems/isystem.h"
+#include "contexts/contexts.h"
+#include "contexts/context_ref.h"
 
 class RotationSystem : public ISystem {
 public:
+    using Contexts = ContextAccess<const PhysicsContext>;
+
+    void init(Engine& engine) override;
     void update(Engine& engine) override;
+
+private:
+    ContextRef<const PhysicsContext> m_pc;
 };
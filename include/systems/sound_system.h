@@ -1,9 +1,16 @@
 #pragma once
 
 #include "systems/isystem.h"
+#include "contexts/contexts.h"
+#include "contexts/context_ref.h"
 
 class SoundSystem : public ISystem {
 public:
+    using Contexts = ContextAccess<EventContext>;
+
     void init(Engine& engine) override;
     void update(Engine& engine) override;
+
+private:
+    ContextRef<EventContext> m_ec;
 };
\ No newline at end of file
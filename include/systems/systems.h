@@ -8,4 +8,5 @@ class LightSystem;
 class CameraSystem;
 class RotationSystem;
 class RenderSystem;
-class SoundSystem;
\ No newline at end of file
+class SoundSystem;
+class TriggerSystem;
\ No newline at end of file
@@ -1,14 +1,26 @@
 #pragma once
 
 #include "systems/isystem.h"
+#include "contexts/contexts.h"
+#include "contexts/context_ref.h"
+#include "core/types/id.h"
+
+#include <span>
 
 class EntityManager;
-class Contact;
+struct Contact;
+struct ContactPair;
 
+// Calls the colliders' on_collision when their pairs begin and end touching, triggers included
 class TriggerSystem : public ISystem {
 public:
+    using Contexts = ContextAccess<const CollisionContext>;
+
+    void init(Engine& engine) override;
     void update(Engine& engine) override;
 
 private:
-    void resolve_trigger_contact(EntityManager& em, const Contact& c);
-};
\ No newline at end of file
+    ContextRef<const CollisionContext> m_cc;
+
+    void notify(EntityManager& em, EntityID e, const ContactPair& pair, std::span<const Contact> contacts);
+};
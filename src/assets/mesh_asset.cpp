@@ -27,6 +27,7 @@ MeshAsset::MeshAsset(std::string name, VertexFormat format, const void* vertices
       m_indices_num(indices_count),
       m_material_id(material_id) {
     compute_local_aabb(vertices);
+    copy_geometry(vertices, indices);
     upload(vertices, indices);
 }
 
@@ -67,6 +68,14 @@ const AABB& MeshAsset::local_aabb() const {
     return m_local_aabb;
 }
 
+const std::vector<glm::vec3>& MeshAsset::positions() const {
+    return m_positions;
+}
+
+const std::vector<uint32_t>& MeshAsset::indices() const {
+    return m_indices;
+}
+
 std::ostream& MeshAsset::print(std::ostream& os) const {
     return os << "MeshAsset(name: " << m_name << ", vertices_num: " << m_vertices_num
               << ", indices_num: " << m_indices_num << ", material_id: " << m_material_id << ")";
@@ -107,6 +116,38 @@ void MeshAsset::compute_local_aabb(const void* vertices) {
     m_local_aabb = {min, max};
 }
 
+void MeshAsset::copy_geometry(const void* vertices, const void* indices) {
+    if (!vertices) {
+        return;
+    }
+
+    m_positions.resize(m_vertices_num);
+    switch (m_format) {
+        case VertexFormat::POS_TEX: {
+            auto vtx = static_cast<const Vertex_PT*>(vertices);
+            for (size_t i = 0; i < m_vertices_num; i++) {
+                m_positions[i] = vtx[i].pos3;
+            }
+            break;
+        }
+        case VertexFormat::POS_NOR_TEX: {
+            auto vtx = static_cast<const Vertex_PNT*>(vertices);
+            for (size_t i = 0; i < m_vertices_num; i++) {
+                m_positions[i] = vtx[i].pos3;
+            }
+            break;
+        }
+        default: {
+            throw std::runtime_error("Unknown vertex format");
+        }
+    }
+
+    if (indices) {
+        auto idx = static_cast<const uint32_t*>(indices);
+        m_indices.assign(idx, idx + m_indices_num);
+    }
+}
+
 void MeshAsset::upload(const void* vertices, const void* indices) {
     if (!vertices || !indices) {
         ERR("[MeshAsset] NULL parameters in upload()");
@@ -32,6 +32,7 @@
 #include "systems/rotation_system.h"
 #include "systems/render_system.h"
 #include "systems/sound_system.h"
+#include "systems/trigger_system.h"
 #include "core/window.h"
 #include "core/engine.h"
 #include "managers/entity_manager.h"
@@ -150,13 +151,13 @@ bool Application::init() {
     engine->em().add<Transform>(spider_id, glm::vec3(4.0f, 0.0f, 0.0f), glm::quat(1, 0, 0, 0), glm::vec3(0.005f));
     engine->em().add<Model>(spider_id, spider_model_id);
     engine->em().add<RigidBody>(spider_id, 0.5f);
-    engine->em().add<Collider>(spider_id);
+    engine->em().add<Collider>(spider_id, ColliderType::Convex);
 
     // Backpack
     engine->em().add<Transform>(backpack_id, glm::vec3(2.0f, 0.0f, 2.0f), glm::quat(1, 0, 0, 0), glm::vec3(0.5f));
     engine->em().add<Model>(backpack_id, backpack_model_id);
     engine->em().add<RigidBody>(backpack_id, 3.0f);
-    engine->em().add<Collider>(backpack_id);
+    engine->em().add<Collider>(backpack_id, ColliderType::Convex);
     auto& rot = engine->em().add<Rotator>(backpack_id);
     rot.speed_deg = 60.0f;
 
@@ -166,9 +167,10 @@ bool Application::init() {
     pl_tr.update_position(glm::vec3(0.0f, pl_tr.scale().y * 0.5f, 0.0f));  // feet on ground
     // engine->em().add<Model>(player_id, player_model_id);
     engine->em().add<RigidBody>(player_id, 60.0f);
-    auto& pl_col = engine->em().add<Collider>(player_id);
+    auto& pl_col = engine->em().add<Collider>(player_id, ColliderType::Capsule);
+    pl_col.size = glm::vec3(0.5f, 0.5f, 0.0f);  // 0.5 radius, 1.0 segment once scaled: 2 units tall
     pl_col.layer = Layers::Player;
-    pl_col.collides_with = Layers::Ground;
+    pl_col.collides_with = Layers::Ground | Layers::Default;  // the floor and the props
     auto& main_camera = engine->em().add<Camera>(player_id, glm::vec3(0.0f, 0.4f, 0.0f));
     main_camera.is_active = true;
     engine->em().add<Player>(player_id, "main_player");
@@ -196,6 +198,7 @@ bool Application::init() {
     engine->sm().add<RigidBodySystem>();
     engine->sm().add<CollisionDetectionSystem>();
     engine->sm().add<CollisionResolutionSystem>();
+    engine->sm().add<TriggerSystem>();
     engine->sm().add<FirstPersonControllerSystem>();
     engine->sm().add<SoundSystem>();
     engine->sm().add<LightSystem>();
@@ -226,6 +229,7 @@ void Application::run() {
 
     // Contexts
     auto& pc = engine->cm().get<PhysicsContext>();
+    auto& ec = engine->cm().get<EventContext>();
     auto& ic = engine->cm().get<InputContext>();
     auto& dc = engine->cm().get<DebugContext>();
 
@@ -236,6 +240,7 @@ void Application::run() {
         last = now;
 
         pc.dt = dt;
+        ec.advance(dt);
 
         // FPS calculation
         frames++;
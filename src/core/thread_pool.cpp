@@ -0,0 +1,124 @@
+#include "core/thread_pool.h"
+#include "core/event_lane.h"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+static thread_local bool t_in_job = false;
+
+ThreadPool& ThreadPool::get() {
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u));
+    return pool;
+}
+
+ThreadPool::ThreadPool(uint32_t threads) {
+    threads = std::clamp(threads, 1u, static_cast<uint32_t>(THREAD_POOL_MAX_THREADS));
+    m_workers.reserve(threads - 1);
+    for (uint32_t i = 1; i < threads; i++) {
+        m_workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& t : m_workers) {
+        t.join();
+    }
+}
+
+void ThreadPool::run(uint32_t chunks, const std::function<void(uint32_t)>& job) {
+    if (chunks == 0) {
+        return;
+    }
+    if (chunks > THREAD_POOL_MAX_CHUNKS) {
+        throw std::runtime_error(std::format("[ThreadPool] {} chunks is more than there are event lanes!", chunks));
+    }
+
+    // Nested jobs stay in the outer chunk's lane, they run serially on its thread
+    if (t_in_job) {
+        for (uint32_t c = 0; c < chunks; c++) {
+            job(c);
+        }
+        return;
+    }
+
+    // Same lanes as on the workers, so events come out in the same order
+    if (chunks == 1 || m_workers.empty()) {
+        for (uint32_t c = 0; c < chunks; c++) {
+            EventLaneScope lane(1 + c);
+            job(c);
+        }
+        return;
+    }
+
+    uint64_t generation;
+    {
+        std::lock_guard lock(m_mutex);
+        generation = ++m_generation;
+        m_job = &job;
+        m_chunks = chunks;
+        m_done.store(0, std::memory_order_relaxed);
+        m_next.store(generation << 32, std::memory_order_release);
+    }
+    m_wake.notify_all();
+
+    // The calling thread works too
+    work(generation, chunks, job);
+
+    std::unique_lock lock(m_mutex);
+    m_finished.wait(lock, [&] { return m_done.load(std::memory_order_acquire) == chunks; });
+    m_job = nullptr;
+}
+
+void ThreadPool::worker_loop() {
+    uint64_t seen = 0;
+    for (;;) {
+        const std::function<void(uint32_t)>* job;
+        uint32_t chunks;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || (m_generation != seen && m_job); });
+            if (m_stop) {
+                return;
+            }
+            seen = m_generation;
+            job = m_job;
+            chunks = m_chunks;
+        }
+
+        work(seen, chunks, *job);
+    }
+}
+
+void ThreadPool::work(uint64_t generation, uint32_t chunks, const std::function<void(uint32_t)>& job) {
+    t_in_job = true;
+
+    uint64_t next = m_next.load(std::memory_order_acquire);
+    for (;;) {
+        if ((next >> 32) != generation || static_cast<uint32_t>(next) >= chunks) {
+            break;
+        }
+        if (!m_next.compare_exchange_weak(next, next + 1, std::memory_order_acq_rel)) {
+            continue;
+        }
+
+        {
+            EventLaneScope lane(1 + static_cast<uint32_t>(next));
+            job(static_cast<uint32_t>(next));
+        }
+
+        if (m_done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks) {
+            std::lock_guard lock(m_mutex);
+            m_finished.notify_one();
+        }
+        next = m_next.load(std::memory_order_acquire);
+    }
+
+    t_in_job = false;
+}
@@ -0,0 +1,177 @@
+#include "core/timer_wheel.h"
+
+#include <cmath>
+#include <algorithm>
+
+TimerWheel::TimerWheel(float tick_seconds) : m_tick(tick_seconds) {
+    m_slots.fill(INVALID_TIMER);
+}
+
+TimerHandle TimerWheel::schedule(float delay, float period, uint32_t kind, uint32_t payload) {
+    uint32_t i = alloc_node();
+    Node& n = m_nodes[i];
+    n.deadline = m_now + to_ticks(delay);
+    n.period = period > 0.0f ? to_ticks(period) : 0;
+    n.kind = kind;
+    n.payload = payload;
+
+    link(i);
+    m_size++;
+
+    return TimerHandle{i, n.generation};
+}
+
+bool TimerWheel::cancel(TimerHandle handle, uint32_t& kind, uint32_t& payload) {
+    if (!is_pending(handle)) {
+        return false;
+    }
+
+    Node& n = m_nodes[handle.index];
+    kind = n.kind;
+    payload = n.payload;
+
+    unlink(handle.index);
+    free_node(handle.index);
+    m_size--;
+
+    return true;
+}
+
+bool TimerWheel::is_pending(TimerHandle handle) const {
+    return handle.index < m_nodes.size() && m_nodes[handle.index].generation == handle.generation &&
+           m_nodes[handle.index].slot != INVALID_TIMER;
+}
+
+void TimerWheel::advance(float dt, std::vector<ExpiredTimer>& expired) {
+    m_accum += dt;
+    uint64_t ticks = static_cast<uint64_t>(m_accum / m_tick);
+    m_accum -= static_cast<double>(ticks) * m_tick;
+
+    // Nothing to expire or cascade, just move the clock
+    if (m_size == 0) {
+        m_now += ticks;
+        return;
+    }
+
+    for (uint64_t t = 0; t < ticks; t++) {
+        tick(expired);
+    }
+}
+
+uint32_t TimerWheel::to_ticks(float seconds) const {
+    double ticks = std::ceil(static_cast<double>(seconds) / m_tick);
+    return static_cast<uint32_t>(std::clamp(ticks, 1.0, static_cast<double>(UINT32_MAX - 1)));
+}
+
+uint32_t TimerWheel::alloc_node() {
+    if (m_free != INVALID_TIMER) {
+        uint32_t i = m_free;
+        m_free = m_nodes[i].next;
+        return i;
+    }
+
+    m_nodes.emplace_back();
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+void TimerWheel::free_node(uint32_t i) {
+    Node& n = m_nodes[i];
+    n.generation++;  // invalidates outstanding handles
+    n.slot = INVALID_TIMER;
+    n.prev = INVALID_TIMER;
+    n.next = m_free;
+    m_free = i;
+}
+
+// Puts the node in the coarsest-fitting slot for its remaining delay
+void TimerWheel::link(uint32_t i) {
+    Node& n = m_nodes[i];
+    uint64_t delta = n.deadline > m_now ? n.deadline - m_now : 0;
+
+    uint32_t level = 0;
+    while (level + 1 < TIMER_WHEEL_LEVELS && delta >= (uint64_t(1) << ((level + 1) * TIMER_WHEEL_SLOT_BITS))) {
+        level++;
+    }
+
+    // Beyond the wheel's range park it in the last slot reachable, it is re-linked on cascade
+    uint64_t range = uint64_t(1) << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS);
+    uint64_t deadline = delta >= range ? m_now + range - 1 : std::max(n.deadline, m_now);
+
+    uint32_t slot = (deadline >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+    n.slot = level * TIMER_WHEEL_SLOTS + slot;
+
+    uint32_t& head = m_slots[n.slot];
+    n.prev = INVALID_TIMER;
+    n.next = head;
+    if (head != INVALID_TIMER) {
+        m_nodes[head].prev = i;
+    }
+    head = i;
+}
+
+void TimerWheel::unlink(uint32_t i) {
+    Node& n = m_nodes[i];
+    if (n.prev != INVALID_TIMER) {
+        m_nodes[n.prev].next = n.next;
+    } else {
+        m_slots[n.slot] = n.next;
+    }
+
+    if (n.next != INVALID_TIMER) {
+        m_nodes[n.next].prev = n.prev;
+    }
+
+    n.slot = INVALID_TIMER;
+    n.prev = INVALID_TIMER;
+    n.next = INVALID_TIMER;
+}
+
+// Moves every timer of the current slot of `level` down to finer levels
+void TimerWheel::cascade(uint32_t level) {
+    uint32_t slot = (m_now >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+    uint32_t i = m_slots[level * TIMER_WHEEL_SLOTS + slot];
+    m_slots[level * TIMER_WHEEL_SLOTS + slot] = INVALID_TIMER;
+
+    while (i != INVALID_TIMER) {
+        uint32_t next = m_nodes[i].next;
+        link(i);
+        i = next;
+    }
+}
+
+void TimerWheel::tick(std::vector<ExpiredTimer>& expired) {
+    m_now++;
+
+    // Entering a new round of a level pulls the next slot of the level above down
+    for (uint32_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        if ((m_now & ((uint64_t(1) << (level * TIMER_WHEEL_SLOT_BITS)) - 1)) != 0) {
+            break;
+        }
+        cascade(level);
+    }
+
+    uint32_t slot = m_now & (TIMER_WHEEL_SLOTS - 1);
+    uint32_t i = m_slots[slot];
+    m_slots[slot] = INVALID_TIMER;
+
+    while (i != INVALID_TIMER) {
+        Node& n = m_nodes[i];
+        uint32_t next = n.next;
+        n.slot = INVALID_TIMER;
+
+        if (n.deadline > m_now) {
+            // Parked beyond the wheel's range, not due yet
+            link(i);
+        } else if (n.period > 0) {
+            expired.push_back(ExpiredTimer{n.kind, n.payload, true});
+            n.deadline = m_now + n.period;
+            link(i);
+        } else {
+            expired.push_back(ExpiredTimer{n.kind, n.payload, false});
+            free_node(i);
+            m_size--;
+        }
+
+        i = next;
+    }
+}
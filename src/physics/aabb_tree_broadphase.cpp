@@ -0,0 +1,350 @@
+#include "physics/aabb_tree_broadphase.h"
+
+#include <algorithm>
+
+static AABB aabb_union(const AABB& a, const AABB& b) {
+    return AABB{glm::min(a.min, b.min), glm::max(a.max, b.max)};
+}
+
+static float aabb_area(const AABB& a) {
+    glm::vec3 d = a.max - a.min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static bool aabb_contains(const AABB& outer, const AABB& inner) {
+    return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::greaterThanEqual(outer.max, inner.max));
+}
+
+static AABB fatten(const AABB& a, float scale) {
+    glm::vec3 margin = glm::max((a.max - a.min) * (AABB_TREE_FAT_RATIO * scale), glm::vec3(AABB_TREE_FAT_MIN));
+    return AABB{a.min - margin, a.max + margin};
+}
+
+ProxyID AabbTreeBroadphase::add_proxy(const AABB& aabb, EntityID entity, const ProxyFilter& filter) {
+    ProxyID p = alloc_proxy(aabb, entity, filter);
+    if (p >= m_leaves.size()) {
+        m_leaves.resize(p + 1, AABB_TREE_NULL);
+        m_moved.resize(p + 1, 0);
+    }
+
+    uint32_t leaf = alloc_node();
+    m_nodes[leaf].aabb = fatten(aabb, 1.0f);
+    m_nodes[leaf].proxy = p;
+    insert_leaf(leaf);
+
+    m_leaves[p] = leaf;
+    m_proxy_count++;
+    mark_moved(p);
+
+    return p;
+}
+
+void AabbTreeBroadphase::remove_proxy(ProxyID proxy) {
+    uint32_t leaf = m_leaves[proxy];
+    remove_leaf(leaf);
+    free_node(leaf);
+
+    m_leaves[proxy] = AABB_TREE_NULL;
+    m_moved[proxy] = 0;
+    m_proxy_count--;
+
+    free_proxy(proxy);
+}
+
+void AabbTreeBroadphase::move_proxy(ProxyID proxy, const AABB& aabb) {
+    AABB& tight = m_proxies[proxy].aabb;
+    if (glm::all(glm::equal(tight.min, aabb.min)) && glm::all(glm::equal(tight.max, aabb.max))) {
+        return;
+    }
+
+    tight = aabb;
+    mark_moved(proxy);
+
+    // Reinsert when the proxy left its fat box, or shrank so much the fat box is mostly empty
+    uint32_t leaf = m_leaves[proxy];
+    const AABB& fat = m_nodes[leaf].aabb;
+    if (aabb_contains(fat, aabb) && aabb_contains(fatten(aabb, 4.0f), fat)) {
+        return;
+    }
+
+    remove_leaf(leaf);
+    m_nodes[leaf].aabb = fatten(aabb, 1.0f);
+    insert_leaf(leaf);
+}
+
+void AabbTreeBroadphase::update_pairs() {
+    if (m_moved_list.empty()) {
+        return;
+    }
+
+    if (m_moved_list.size() * AABB_TREE_FULL_PASS_RATIO > m_proxy_count) {
+        self_pairs();
+    } else {
+        // Pairs only change where a proxy moved, the rest are still valid
+        m_stale.clear();
+        for (const BroadphasePair& pair : m_pairs.pairs()) {
+            if ((m_moved[pair.a] || m_moved[pair.b]) && !aabb_overlap(m_proxies[pair.a].aabb, m_proxies[pair.b].aabb)) {
+                m_stale.push_back(pair);
+            }
+        }
+        for (const BroadphasePair& pair : m_stale) {
+            m_pairs.remove(pair.a, pair.b);
+        }
+
+        for (ProxyID p : m_moved_list) {
+            if (m_moved[p]) {
+                query_pairs(p);
+            }
+        }
+    }
+
+    forget_moved();
+}
+
+void AabbTreeBroadphase::forget_moved() {
+    for (ProxyID p : m_moved_list) {
+        m_moved[p] = 0;
+    }
+    m_moved_list.clear();
+}
+
+uint32_t AabbTreeBroadphase::alloc_node() {
+    if (m_free != AABB_TREE_NULL) {
+        uint32_t node = m_free;
+        m_free = m_nodes[node].parent;
+        m_nodes[node] = Node{};
+        return node;
+    }
+
+    m_nodes.emplace_back();
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+void AabbTreeBroadphase::free_node(uint32_t node) {
+    m_nodes[node].parent = m_free;
+    m_nodes[node].height = UINT32_MAX;
+    m_free = node;
+}
+
+void AabbTreeBroadphase::insert_leaf(uint32_t leaf) {
+    if (m_root == AABB_TREE_NULL) {
+        m_root = leaf;
+        m_nodes[leaf].parent = AABB_TREE_NULL;
+        return;
+    }
+
+    // Descend towards the sibling that increases the total surface area the least
+    AABB leaf_aabb = m_nodes[leaf].aabb;
+    uint32_t index = m_root;
+    while (!m_nodes[index].is_leaf()) {
+        const Node& n = m_nodes[index];
+        float area = aabb_area(n.aabb);
+        float combined_area = aabb_area(aabb_union(n.aabb, leaf_aabb));
+
+        // Cost of making a new parent for this node and the leaf, and the cost
+        // pushed down to the children from enlarging this node
+        float cost = 2.0f * combined_area;
+        float inheritance = 2.0f * (combined_area - area);
+
+        auto child_cost = [&](uint32_t child) {
+            const Node& c = m_nodes[child];
+            float enlarged = aabb_area(aabb_union(c.aabb, leaf_aabb));
+            return (c.is_leaf() ? enlarged : enlarged - aabb_area(c.aabb)) + inheritance;
+        };
+
+        float cost1 = child_cost(n.child1);
+        float cost2 = child_cost(n.child2);
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+
+        index = cost1 < cost2 ? n.child1 : n.child2;
+    }
+
+    uint32_t sibling = index;
+    uint32_t old_parent = m_nodes[sibling].parent;
+    uint32_t new_parent = alloc_node();
+
+    Node& np = m_nodes[new_parent];
+    np.parent = old_parent;
+    np.aabb = aabb_union(leaf_aabb, m_nodes[sibling].aabb);
+    np.height = m_nodes[sibling].height + 1;
+    np.child1 = sibling;
+    np.child2 = leaf;
+
+    if (old_parent != AABB_TREE_NULL) {
+        Node& op = m_nodes[old_parent];
+        (op.child1 == sibling ? op.child1 : op.child2) = new_parent;
+    } else {
+        m_root = new_parent;
+    }
+    m_nodes[sibling].parent = new_parent;
+    m_nodes[leaf].parent = new_parent;
+
+    refit(new_parent);
+}
+
+void AabbTreeBroadphase::remove_leaf(uint32_t leaf) {
+    if (leaf == m_root) {
+        m_root = AABB_TREE_NULL;
+        return;
+    }
+
+    uint32_t parent = m_nodes[leaf].parent;
+    uint32_t grand_parent = m_nodes[parent].parent;
+    uint32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    // The sibling takes the parent's place
+    m_nodes[sibling].parent = grand_parent;
+    if (grand_parent != AABB_TREE_NULL) {
+        Node& gp = m_nodes[grand_parent];
+        (gp.child1 == parent ? gp.child1 : gp.child2) = sibling;
+    } else {
+        m_root = sibling;
+    }
+    free_node(parent);
+
+    m_nodes[leaf].parent = AABB_TREE_NULL;
+
+    if (grand_parent != AABB_TREE_NULL) {
+        refit(grand_parent);
+    }
+}
+
+// Walks up from `node` rebalancing and recomputing heights and bounds
+void AabbTreeBroadphase::refit(uint32_t node) {
+    uint32_t index = node;
+    while (index != AABB_TREE_NULL) {
+        index = balance(index);
+
+        Node& n = m_nodes[index];
+        const Node& c1 = m_nodes[n.child1];
+        const Node& c2 = m_nodes[n.child2];
+        n.height = 1 + std::max(c1.height, c2.height);
+        n.aabb = aabb_union(c1.aabb, c2.aabb);
+
+        index = n.parent;
+    }
+}
+
+// Rotates the taller grandchild up when the children's heights differ by more than one.
+// Returns the node now at a's position
+uint32_t AabbTreeBroadphase::balance(uint32_t a) {
+    Node& A = m_nodes[a];
+    if (A.is_leaf() || A.height < 2) {
+        return a;
+    }
+
+    uint32_t b = A.child1;
+    uint32_t c = A.child2;
+    Node& B = m_nodes[b];
+    Node& C = m_nodes[c];
+    int32_t diff = static_cast<int32_t>(C.height) - static_cast<int32_t>(B.height);
+
+    // Promotes `up` (a child of A) to A's place, A keeps `keep` and takes one of up's children
+    auto rotate = [&](uint32_t up, uint32_t keep, bool a_child1) {
+        Node& U = m_nodes[up];
+        const Node& K = m_nodes[keep];
+        uint32_t f = U.child1;
+        uint32_t g = U.child2;
+        Node& F = m_nodes[f];
+        Node& G = m_nodes[g];
+
+        U.child1 = a;
+        U.parent = A.parent;
+        A.parent = up;
+
+        if (U.parent != AABB_TREE_NULL) {
+            Node& P = m_nodes[U.parent];
+            (P.child1 == a ? P.child1 : P.child2) = up;
+        } else {
+            m_root = up;
+        }
+
+        // The taller grandchild stays with `up`, the other goes to A
+        uint32_t stay = F.height > G.height ? f : g;
+        uint32_t move = stay == f ? g : f;
+        U.child2 = stay;
+        (a_child1 ? A.child1 : A.child2) = move;
+        m_nodes[move].parent = a;
+
+        A.aabb = aabb_union(K.aabb, m_nodes[move].aabb);
+        A.height = 1 + std::max(K.height, m_nodes[move].height);
+        U.aabb = aabb_union(A.aabb, m_nodes[stay].aabb);
+        U.height = 1 + std::max(A.height, m_nodes[stay].height);
+
+        return up;
+    };
+
+    if (diff > 1) {
+        return rotate(c, b, false);
+    }
+    if (diff < -1) {
+        return rotate(b, c, true);
+    }
+
+    return a;
+}
+
+void AabbTreeBroadphase::mark_moved(ProxyID proxy) {
+    if (!m_moved[proxy]) {
+        m_moved[proxy] = 1;
+        m_moved_list.push_back(proxy);
+    }
+}
+
+// Adds the pairs between a moved proxy and every proxy its tight box overlaps
+void AabbTreeBroadphase::query_pairs(ProxyID proxy) {
+    const AABB& tight = m_proxies[proxy].aabb;
+    query(tight, [&](ProxyID other) {
+        if (other != proxy && can_pair(proxy, other) && aabb_overlap(tight, m_proxies[other].aabb)) {
+            m_pairs.add(proxy, other);
+        }
+    });
+}
+
+// Tree-vs-tree traversal of the whole hierarchy against itself, finding every pair once
+void AabbTreeBroadphase::self_pairs() {
+    m_pairs.begin_rebuild();
+
+    // Node pairs to visit, a == b tests a subtree against itself
+    m_stack.clear();
+    if (m_root != AABB_TREE_NULL) {
+        m_stack.push_back(m_root);
+        m_stack.push_back(m_root);
+    }
+
+    while (!m_stack.empty()) {
+        uint32_t b = m_stack.back();
+        m_stack.pop_back();
+        uint32_t a = m_stack.back();
+        m_stack.pop_back();
+
+        const Node& A = m_nodes[a];
+        const Node& B = m_nodes[b];
+
+        if (a == b) {
+            if (!A.is_leaf()) {
+                m_stack.insert(m_stack.end(), {A.child1, A.child1, A.child2, A.child2, A.child1, A.child2});
+            }
+            continue;
+        }
+
+        if (!aabb_overlap(A.aabb, B.aabb)) {
+            continue;
+        }
+
+        if (A.is_leaf() && B.is_leaf()) {
+            if (can_pair(A.proxy, B.proxy) && aabb_overlap(m_proxies[A.proxy].aabb, m_proxies[B.proxy].aabb)) {
+                m_pairs.add(A.proxy, B.proxy);
+            }
+        } else if (B.is_leaf() || (!A.is_leaf() && A.height >= B.height)) {
+            // Descend the larger subtree
+            m_stack.insert(m_stack.end(), {A.child1, b, A.child2, b});
+        } else {
+            m_stack.insert(m_stack.end(), {a, B.child1, a, B.child2});
+        }
+    }
+
+    m_pairs.end_rebuild();
+}
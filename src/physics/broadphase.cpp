@@ -0,0 +1,23 @@
+#include "physics/broadphase.h"
+#include "physics/sap_broadphase.h"
+#include "physics/aabb_tree_broadphase.h"
+#include "physics/grid_broadphase.h"
+
+#include <stdexcept>
+
+std::unique_ptr<IBroadphase> make_broadphase(BroadphaseType type) {
+    switch (type) {
+        case BroadphaseType::SAP: {
+            return std::make_unique<SAPBroadphase>();
+        }
+        case BroadphaseType::AabbTree: {
+            return std::make_unique<AabbTreeBroadphase>();
+        }
+        case BroadphaseType::Grid: {
+            return std::make_unique<GridBroadphase>();
+        }
+        default: {
+            throw std::runtime_error("[Broadphase] Unknown broadphase type!");
+        }
+    }
+}
@@ -0,0 +1,226 @@
+#include "physics/collision_mesh.h"
+#include "physics/narrowphase.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+void TriangleMesh::add(std::span<const glm::vec3> positions, std::span<const uint32_t> indices) {
+    uint32_t base = static_cast<uint32_t>(m_vertices.size());
+    m_vertices.insert(m_vertices.end(), positions.begin(), positions.end());
+
+    uint32_t count = static_cast<uint32_t>(indices.empty() ? positions.size() : indices.size());
+    for (uint32_t i = 0; i + 2 < count; i += 3) {
+        Triangle t;
+        for (uint32_t k = 0; k < 3; k++) {
+            uint32_t v = indices.empty() ? i + k : indices[i + k];
+            if (v >= positions.size()) {
+                throw std::runtime_error("[TriangleMesh] Index out of range!");
+            }
+            t.v[k] = base + v;
+        }
+
+        const glm::vec3& a = m_vertices[t.v[0]];
+        const glm::vec3& b = m_vertices[t.v[1]];
+        const glm::vec3& c = m_vertices[t.v[2]];
+        t.aabb = AABB{glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c))};
+        m_triangles.push_back(t);
+    }
+}
+
+void TriangleMesh::build() {
+    m_nodes.clear();
+    if (m_triangles.empty()) {
+        return;
+    }
+
+    struct Task {
+        uint32_t node;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    auto center = [](const Triangle& t) { return (t.aabb.min + t.aabb.max) * 0.5f; };
+
+    std::vector<Task> tasks;
+    m_nodes.emplace_back();
+    tasks.push_back(Task{0, 0, static_cast<uint32_t>(m_triangles.size())});
+
+    while (!tasks.empty()) {
+        Task t = tasks.back();
+        tasks.pop_back();
+
+        AABB bounds = m_triangles[t.begin].aabb;
+        AABB centers{center(m_triangles[t.begin]), center(m_triangles[t.begin])};
+        for (uint32_t i = t.begin + 1; i < t.end; i++) {
+            bounds.min = glm::min(bounds.min, m_triangles[i].aabb.min);
+            bounds.max = glm::max(bounds.max, m_triangles[i].aabb.max);
+            centers.min = glm::min(centers.min, center(m_triangles[i]));
+            centers.max = glm::max(centers.max, center(m_triangles[i]));
+        }
+        m_nodes[t.node].aabb = bounds;
+
+        glm::vec3 spread = centers.max - centers.min;
+        uint32_t axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+
+        // Triangles sharing one center can't be split, they stay in a bigger leaf
+        if (t.end - t.begin <= MESH_LEAF_SIZE || spread[axis] <= 0.0f) {
+            m_nodes[t.node].first = t.begin;
+            m_nodes[t.node].count = t.end - t.begin;
+            continue;
+        }
+
+        uint32_t mid = (t.begin + t.end) / 2;
+        std::nth_element(m_triangles.begin() + t.begin, m_triangles.begin() + mid, m_triangles.begin() + t.end,
+                         [&](const Triangle& a, const Triangle& b) { return center(a)[axis] < center(b)[axis]; });
+
+        uint32_t left = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+        m_nodes.emplace_back();
+        m_nodes[t.node].first = left;
+
+        tasks.push_back(Task{left, t.begin, mid});
+        tasks.push_back(Task{left + 1, mid, t.end});
+    }
+}
+
+// Entry distance of the ray into the box, false when it misses within tmax
+static bool ray_vs_aabb(const glm::vec3& o, const glm::vec3& inv_d, const AABB& aabb, float tmax, float& t_enter) {
+    glm::vec3 t1 = (aabb.min - o) * inv_d;
+    glm::vec3 t2 = (aabb.max - o) * inv_d;
+    glm::vec3 t_min = glm::min(t1, t2);
+    glm::vec3 t_max = glm::max(t1, t2);
+    t_enter = std::max(std::max(t_min.x, t_min.y), std::max(t_min.z, 0.0f));
+    float t_exit = std::min(std::min(t_max.x, t_max.y), std::min(t_max.z, tmax));
+    return t_enter <= t_exit;
+}
+
+// Moller-Trumbore, both faces count
+static bool ray_vs_triangle(const glm::vec3& o, const glm::vec3& d, const glm::vec3& a, const glm::vec3& b,
+                            const glm::vec3& c, float& t) {
+    glm::vec3 e1 = b - a;
+    glm::vec3 e2 = c - a;
+    glm::vec3 p = glm::cross(d, e2);
+    float det = glm::dot(e1, p);
+    if (std::abs(det) < COL_EPS * glm::length(e1) * glm::length(e2)) {
+        return false;
+    }
+
+    float inv_det = 1.0f / det;
+    glm::vec3 s = o - a;
+    float u = glm::dot(s, p) * inv_det;
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(d, q) * inv_det;
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+
+    t = glm::dot(e2, q) * inv_det;
+    return t >= 0.0f;
+}
+
+bool TriangleMesh::raycast(const glm::vec3& o, const glm::vec3& d, float tmax, float& t, uint32_t& tri) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    // Huge instead of infinite for axis-parallel rays, no 0 * inf in the slab test
+    glm::vec3 inv_d;
+    for (uint32_t k = 0; k < 3; k++) {
+        inv_d[k] = std::abs(d[k]) > 1e-20f ? 1.0f / d[k] : std::copysign(1e20f, d[k]);
+    }
+
+    bool hit = false;
+    float best = tmax;
+    uint32_t stack[MESH_STACK_SIZE];
+    uint32_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = m_nodes[stack[--top]];
+        float t_enter;
+        if (!ray_vs_aabb(o, inv_d, node.aabb, best, t_enter)) {
+            continue;
+        }
+
+        if (node.count == 0) {
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+            continue;
+        }
+
+        for (uint32_t i = node.first; i < node.first + node.count; i++) {
+            const Triangle& tr = m_triangles[i];
+            float t_hit;
+            if (ray_vs_triangle(o, d, m_vertices[tr.v[0]], m_vertices[tr.v[1]], m_vertices[tr.v[2]], t_hit) &&
+                t_hit <= best) {
+                best = t_hit;
+                tri = i;
+                hit = true;
+            }
+        }
+    }
+
+    t = best;
+    return hit;
+}
+
+// Direction i of a Fibonacci sphere, evenly spread over all of them
+static glm::vec3 hull_direction(uint32_t i) {
+    const float golden_angle = 2.39996323f;
+    float y = 1.0f - 2.0f * (static_cast<float>(i) + 0.5f) / CONVEX_HULL_DIRECTIONS;
+    float r = std::sqrt(std::max(1.0f - y * y, 0.0f));
+    float phi = golden_angle * static_cast<float>(i);
+    return glm::vec3(r * std::cos(phi), y, r * std::sin(phi));
+}
+
+void ConvexHull::build(std::span<const glm::vec3> points) {
+    if (points.empty()) {
+        throw std::runtime_error("[ConvexHull] Building a hull from no points!");
+    }
+
+    std::vector<uint8_t> kept(points.size(), 0);
+    for (uint32_t i = 0; i < CONVEX_HULL_DIRECTIONS; i++) {
+        glm::vec3 d = hull_direction(i);
+
+        uint32_t best = 0;
+        float best_dot = glm::dot(points[0], d);
+        for (uint32_t p = 1; p < points.size(); p++) {
+            float dot = glm::dot(points[p], d);
+            if (dot > best_dot) {
+                best_dot = dot;
+                best = p;
+            }
+        }
+        kept[best] = 1;
+    }
+
+    m_vertices.clear();
+    for (uint32_t p = 0; p < points.size(); p++) {
+        if (kept[p]) {
+            m_vertices.push_back(points[p]);
+        }
+    }
+
+    m_bounds = AABB{m_vertices[0], m_vertices[0]};
+    m_centroid = glm::vec3(0.0f);
+    for (const glm::vec3& v : m_vertices) {
+        m_bounds.min = glm::min(m_bounds.min, v);
+        m_bounds.max = glm::max(m_bounds.max, v);
+        m_centroid += v;
+    }
+    m_centroid /= static_cast<float>(m_vertices.size());
+
+    // The support distance along a direction bounds the surface distance from above,
+    // the smallest one over the same directions is close to the inscribed radius
+    m_inner_radius = FLT_MAX;
+    for (uint32_t i = 0; i < CONVEX_HULL_DIRECTIONS; i++) {
+        glm::vec3 d = hull_direction(i);
+        m_inner_radius = std::min(m_inner_radius, glm::dot(m_vertices[support(d)] - m_centroid, d));
+    }
+    m_inner_radius = std::max(m_inner_radius, 0.0f);
+}
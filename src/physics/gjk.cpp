@@ -0,0 +1,470 @@
+#include "physics/gjk.h"
+#include "physics/narrowphase.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+glm::vec3 SupportShape::support(const glm::vec3& d, uint32_t& index) const {
+    switch (kind) {
+        case SupportKind::Point: {
+            index = 0;
+            return points[0];
+        }
+        case SupportKind::Segment: {
+            index = glm::dot(points[1] - points[0], d) > 0.0f ? 1 : 0;
+            return points[index];
+        }
+        case SupportKind::Triangle: {
+            float d0 = glm::dot(points[0], d);
+            float d1 = glm::dot(points[1], d);
+            float d2 = glm::dot(points[2], d);
+            index = d0 >= d1 ? (d0 >= d2 ? 0 : 2) : (d1 >= d2 ? 1 : 2);
+            return points[index];
+        }
+        case SupportKind::Box: {
+            // One bit per axis for the sign of the corner
+            index = 0;
+            for (uint32_t k = 0; k < 3; k++) {
+                if (glm::dot(obb->axes[k], d) > 0.0f) {
+                    index |= 1u << k;
+                }
+            }
+            return vertex(index);
+        }
+        case SupportKind::Hull: {
+            return convex->support(d, index);
+        }
+        default: {
+            throw std::runtime_error("[SupportShape] Unknown support kind!");
+        }
+    }
+}
+
+glm::vec3 SupportShape::vertex(uint32_t index) const {
+    switch (kind) {
+        case SupportKind::Point:
+        case SupportKind::Segment:
+        case SupportKind::Triangle: {
+            return points[index];
+        }
+        case SupportKind::Box: {
+            glm::vec3 p = obb->center;
+            for (uint32_t k = 0; k < 3; k++) {
+                float h = obb->half_extents[k];
+                p += obb->axes[k] * ((index >> k) & 1 ? h : -h);
+            }
+            return p;
+        }
+        case SupportKind::Hull: {
+            return convex->vertex(index);
+        }
+        default: {
+            throw std::runtime_error("[SupportShape] Unknown support kind!");
+        }
+    }
+}
+
+uint32_t SupportShape::vertex_count() const {
+    switch (kind) {
+        case SupportKind::Point: {
+            return 1;
+        }
+        case SupportKind::Segment: {
+            return 2;
+        }
+        case SupportKind::Triangle: {
+            return 3;
+        }
+        case SupportKind::Box: {
+            return 8;
+        }
+        case SupportKind::Hull: {
+            return convex->hull->vertex_count();
+        }
+        default: {
+            throw std::runtime_error("[SupportShape] Unknown support kind!");
+        }
+    }
+}
+
+glm::vec3 SupportShape::center() const {
+    switch (kind) {
+        case SupportKind::Point: {
+            return points[0];
+        }
+        case SupportKind::Segment: {
+            return (points[0] + points[1]) * 0.5f;
+        }
+        case SupportKind::Triangle: {
+            return (points[0] + points[1] + points[2]) / 3.0f;
+        }
+        case SupportKind::Box: {
+            return obb->center;
+        }
+        case SupportKind::Hull: {
+            return convex->basis * convex->hull->centroid() + convex->origin;
+        }
+        default: {
+            throw std::runtime_error("[SupportShape] Unknown support kind!");
+        }
+    }
+}
+
+static GjkVertex minkowski_support(const SupportShape& A, const SupportShape& B, const glm::vec3& d) {
+    GjkVertex v;
+    v.a = A.support(d, v.ia);
+    v.b = B.support(-d, v.ib);
+    v.w = v.a - v.b;
+    return v;
+}
+
+// Faces of a tetrahedron, each followed by the vertex opposite to it
+static const uint32_t TETRA_FACES[4][4] = {{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}};
+
+// Keeps the simplex vertices with a non-zero weight
+static void reduce_simplex(GjkSimplex& s, const float* weights, const uint32_t* ids, uint32_t count) {
+    GjkVertex kept[4];
+    float kept_weights[4];
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (weights[i] > 0.0f) {
+            kept[n] = s.v[ids[i]];
+            kept_weights[n] = weights[i];
+            n++;
+        }
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        s.v[i] = kept[i];
+        s.weights[i] = kept_weights[i];
+    }
+    s.count = n;
+}
+
+// Origin and d on different sides of plane abc, a flat tetrahedron counts as outside
+static bool outside_of_plane(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+    glm::vec3 n = glm::cross(b - a, c - a);
+    float sign_o = glm::dot(-a, n);
+    float sign_d = glm::dot(d - a, n);
+    return sign_d * sign_d <= COL_EPS * COL_EPS * glm::dot(n, n) || sign_o * sign_d < 0.0f;
+}
+
+// Reduces the simplex to the feature closest to the origin and returns that point,
+// true when the simplex is a tetrahedron containing the origin
+static bool closest_to_origin(GjkSimplex& s, glm::vec3& v) {
+    switch (s.count) {
+        case 1: {
+            s.weights[0] = 1.0f;
+            v = s.v[0].w;
+            return false;
+        }
+        case 2: {
+            glm::vec3 ab = s.v[1].w - s.v[0].w;
+            float len2 = glm::dot(ab, ab);
+            float t = len2 > 0.0f ? glm::clamp(glm::dot(-s.v[0].w, ab) / len2, 0.0f, 1.0f) : 0.0f;
+            float weights[2] = {1.0f - t, t};
+            uint32_t ids[2] = {0, 1};
+            v = s.v[0].w + ab * t;  // before the reduction, which can drop v[0]
+            reduce_simplex(s, weights, ids, 2);
+            return false;
+        }
+        case 3: {
+            float weights[3];
+            v = closest_point_on_triangle(s.v[0].w, s.v[1].w, s.v[2].w, glm::vec3(0.0f), weights);
+            uint32_t ids[3] = {0, 1, 2};
+            reduce_simplex(s, weights, ids, 3);
+            return false;
+        }
+        case 4: {
+            float best = FLT_MAX;
+            float best_weights[3] = {0.0f, 0.0f, 0.0f};
+            uint32_t best_face = 4;
+            for (uint32_t f = 0; f < 4; f++) {
+                const uint32_t* F = TETRA_FACES[f];
+                if (!outside_of_plane(s.v[F[0]].w, s.v[F[1]].w, s.v[F[2]].w, s.v[F[3]].w)) {
+                    continue;
+                }
+
+                float weights[3];
+                glm::vec3 q =
+                    closest_point_on_triangle(s.v[F[0]].w, s.v[F[1]].w, s.v[F[2]].w, glm::vec3(0.0f), weights);
+                if (glm::dot(q, q) < best) {
+                    best = glm::dot(q, q);
+                    best_face = f;
+                    v = q;
+                    std::copy(weights, weights + 3, best_weights);
+                }
+            }
+
+            if (best_face == 4) {
+                return true;
+            }
+
+            reduce_simplex(s, best_weights, TETRA_FACES[best_face], 3);
+            return false;
+        }
+        default: {
+            throw std::runtime_error("[GJK] Invalid simplex size!");
+        }
+    }
+}
+
+bool gjk_distance(const SupportShape& A, const SupportShape& B, GjkSimplex& s, float& distance, glm::vec3& pa,
+                  glm::vec3& pb, GjkCache* cache) {
+    s.count = 0;
+    if (cache) {
+        for (uint32_t i = 0; i < cache->count; i++) {
+            // Stale if a shape changed since, e.g. got a new hull
+            if (cache->a[i] >= A.vertex_count() || cache->b[i] >= B.vertex_count()) {
+                s.count = 0;
+                break;
+            }
+
+            GjkVertex& v = s.v[s.count++];
+            v.ia = cache->a[i];
+            v.ib = cache->b[i];
+            v.a = A.vertex(v.ia);
+            v.b = B.vertex(v.ib);
+            v.w = v.a - v.b;
+        }
+    }
+    if (s.count == 0) {
+        glm::vec3 d = B.center() - A.center();
+        s.v[s.count++] = minkowski_support(A, B, glm::dot(d, d) > COL_EPS ? d : glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+
+    bool overlap = false;
+    glm::vec3 v(0.0f);
+    for (uint32_t it = 0;; it++) {
+        if (closest_to_origin(s, v) || glm::dot(v, v) <= GJK_EPSILON) {
+            overlap = true;
+            break;
+        }
+        if (it == GJK_MAX_ITERATIONS) {
+            break;
+        }
+
+        // Stop once the next support point gets no closer to the origin
+        GjkVertex w = minkowski_support(A, B, -v);
+        float vv = glm::dot(v, v);
+        bool known = false;
+        for (uint32_t i = 0; i < s.count; i++) {
+            known |= s.v[i].ia == w.ia && s.v[i].ib == w.ib;
+        }
+        if (known || vv - glm::dot(v, w.w) <= GJK_TOLERANCE * vv) {
+            break;
+        }
+
+        s.v[s.count++] = w;
+    }
+
+    if (cache) {
+        cache->count = s.count;
+        for (uint32_t i = 0; i < s.count; i++) {
+            cache->a[i] = s.v[i].ia;
+            cache->b[i] = s.v[i].ib;
+        }
+    }
+
+    if (overlap) {
+        distance = 0.0f;
+        return false;
+    }
+
+    pa = glm::vec3(0.0f);
+    pb = glm::vec3(0.0f);
+    for (uint32_t i = 0; i < s.count; i++) {
+        pa += s.v[i].a * s.weights[i];
+        pb += s.v[i].b * s.weights[i];
+    }
+    distance = glm::length(v);
+    return true;
+}
+
+struct EpaFace {
+    uint32_t v[3];
+    glm::vec3 normal;
+    float distance;
+};
+
+struct EpaEdge {
+    uint32_t a;
+    uint32_t b;
+};
+
+static bool make_face(const GjkVertex* verts, uint32_t a, uint32_t b, uint32_t c, EpaFace& f) {
+    glm::vec3 n = glm::cross(verts[b].w - verts[a].w, verts[c].w - verts[a].w);
+    float len = glm::length(n);
+    if (len <= COL_EPS * COL_EPS) {
+        return false;
+    }
+
+    f.v[0] = a;
+    f.v[1] = b;
+    f.v[2] = c;
+    f.normal = n / len;
+    f.distance = glm::dot(f.normal, verts[a].w);
+    return true;
+}
+
+// Grows a simplex touching the origin into a tetrahedron around it
+static bool blow_up(const SupportShape& A, const SupportShape& B, GjkVertex* verts, uint32_t& count) {
+    static const glm::vec3 axes[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+    if (count == 1) {
+        for (const glm::vec3& d : axes) {
+            GjkVertex w = minkowski_support(A, B, d);
+            glm::vec3 e = w.w - verts[0].w;
+            if (glm::dot(e, e) > COL_EPS) {
+                verts[count++] = w;
+                break;
+            }
+        }
+    }
+
+    if (count == 2) {
+        glm::vec3 line = glm::normalize(verts[1].w - verts[0].w);
+        glm::vec3 abs_line = glm::abs(line);
+        uint32_t k = abs_line.x < abs_line.y ? (abs_line.x < abs_line.z ? 0 : 2) : (abs_line.y < abs_line.z ? 1 : 2);
+        glm::vec3 perp = glm::normalize(glm::cross(line, axes[2 * k]));
+
+        // Around the line in 60 degree steps
+        for (uint32_t i = 0; i < 6; i++) {
+            float angle = static_cast<float>(i) * 1.04719755f;
+            glm::vec3 d = perp * std::cos(angle) + glm::cross(line, perp) * std::sin(angle);
+            GjkVertex w = minkowski_support(A, B, d);
+            glm::vec3 e = glm::cross(w.w - verts[0].w, line);
+            if (glm::dot(e, e) > COL_EPS) {
+                verts[count++] = w;
+                break;
+            }
+        }
+    }
+
+    if (count == 3) {
+        glm::vec3 n = glm::cross(verts[1].w - verts[0].w, verts[2].w - verts[0].w);
+        float len = glm::length(n);
+        if (len > COL_EPS * COL_EPS) {
+            n /= len;
+            for (float sign : {1.0f, -1.0f}) {
+                GjkVertex w = minkowski_support(A, B, n * sign);
+                if (std::abs(glm::dot(w.w - verts[0].w, n)) > COL_EPS) {
+                    verts[count++] = w;
+                    break;
+                }
+            }
+        }
+    }
+
+    return count == 4;
+}
+
+bool epa_penetration(const SupportShape& A, const SupportShape& B, const GjkSimplex& simplex, glm::vec3& normal,
+                     float& depth, glm::vec3& pa, glm::vec3& pb) {
+    GjkVertex verts[EPA_MAX_ITERATIONS + 4];
+    uint32_t vert_count = simplex.count;
+    std::copy(simplex.v, simplex.v + simplex.count, verts);
+    if (!blow_up(A, B, verts, vert_count)) {
+        return false;
+    }
+
+    EpaFace faces[EPA_MAX_FACES];
+    uint32_t face_count = 0;
+    for (const uint32_t* T : TETRA_FACES) {
+        EpaFace& f = faces[face_count];
+        if (!make_face(verts, T[0], T[1], T[2], f)) {
+            return false;
+        }
+
+        // Outward, away from the fourth vertex
+        if (glm::dot(f.normal, verts[T[3]].w - verts[T[0]].w) > 0.0f) {
+            make_face(verts, T[0], T[2], T[1], f);
+        }
+        face_count++;
+    }
+
+    EpaEdge edges[EPA_MAX_FACES * 3];
+    uint32_t closest = 0;
+    for (uint32_t it = 0; it < EPA_MAX_ITERATIONS; it++) {
+        closest = 0;
+        for (uint32_t i = 1; i < face_count; i++) {
+            if (faces[i].distance < faces[closest].distance) {
+                closest = i;
+            }
+        }
+
+        const EpaFace& best = faces[closest];
+        GjkVertex w = minkowski_support(A, B, best.normal);
+        if (glm::dot(w.w, best.normal) - best.distance < EPA_TOLERANCE) {
+            break;
+        }
+
+        // Remove the faces the new point sees, their outline is the horizon
+        uint32_t new_vert = vert_count;
+        verts[vert_count++] = w;
+        uint32_t edge_count = 0;
+        for (uint32_t i = 0; i < face_count;) {
+            const EpaFace& f = faces[i];
+            if (glm::dot(f.normal, w.w - verts[f.v[0]].w) <= 0.0f) {
+                i++;
+                continue;
+            }
+
+            for (uint32_t e = 0; e < 3; e++) {
+                uint32_t a = f.v[e];
+                uint32_t b = f.v[(e + 1) % 3];
+
+                // An edge shared with another removed face is inside the hole
+                uint32_t shared = edge_count;
+                for (uint32_t j = 0; j < edge_count; j++) {
+                    if (edges[j].a == b && edges[j].b == a) {
+                        shared = j;
+                        break;
+                    }
+                }
+                if (shared < edge_count) {
+                    edges[shared] = edges[--edge_count];
+                } else {
+                    edges[edge_count++] = EpaEdge{a, b};
+                }
+            }
+            faces[i] = faces[--face_count];
+        }
+
+        if (face_count + edge_count > EPA_MAX_FACES) {
+            return false;
+        }
+        for (uint32_t e = 0; e < edge_count; e++) {
+            if (make_face(verts, edges[e].a, edges[e].b, new_vert, faces[face_count])) {
+                face_count++;
+            }
+        }
+
+        if (face_count == 0) {
+            return false;
+        }
+    }
+
+    closest = 0;
+    for (uint32_t i = 1; i < face_count; i++) {
+        if (faces[i].distance < faces[closest].distance) {
+            closest = i;
+        }
+    }
+
+    const EpaFace& f = faces[closest];
+    float weights[3];
+    closest_point_on_triangle(verts[f.v[0]].w, verts[f.v[1]].w, verts[f.v[2]].w, f.normal * f.distance, weights);
+
+    normal = f.normal;
+    depth = std::max(f.distance, 0.0f);
+    pa = glm::vec3(0.0f);
+    pb = glm::vec3(0.0f);
+    for (uint32_t k = 0; k < 3; k++) {
+        pa += verts[f.v[k]].a * weights[k];
+        pb += verts[f.v[k]].b * weights[k];
+    }
+    return true;
+}
@@ -0,0 +1,159 @@
+#include "physics/grid_broadphase.h"
+#include "core/thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define GRID_COORD_LIMIT 1e9f
+
+static uint32_t cell_hash(const glm::ivec3& c) {
+    return (static_cast<uint32_t>(c.x) * 73856093u) ^ (static_cast<uint32_t>(c.y) * 19349663u) ^
+           (static_cast<uint32_t>(c.z) * 83492791u);
+}
+
+ProxyID GridBroadphase::add_proxy(const AABB& aabb, EntityID entity, const ProxyFilter& filter) {
+    return alloc_proxy(aabb, entity, filter);
+}
+
+void GridBroadphase::remove_proxy(ProxyID proxy) {
+    free_proxy(proxy);
+}
+
+void GridBroadphase::move_proxy(ProxyID proxy, const AABB& aabb) {
+    m_proxies[proxy].aabb = aabb;
+}
+
+void GridBroadphase::update_pairs() {
+    m_cell_size = m_fixed_cell_size > 0.0f ? m_fixed_cell_size : compute_cell_size();
+
+    uint32_t count = static_cast<uint32_t>(m_proxies.size());
+    uint32_t chunks = parallel_chunks(count, GRID_PARALLEL_GRAIN);
+
+    // Insert every proxy in the cells it overlaps, one buffer per chunk
+    m_chunk_cells.resize(chunks);
+    parallel_for(count, GRID_PARALLEL_GRAIN, [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+        ChunkCells& out = m_chunk_cells[chunk];
+        out.cells.clear();
+        out.oversized.clear();
+
+        for (ProxyID p = begin; p < end; p++) {
+            const Proxy& proxy = m_proxies[p];
+            if (!proxy.alive) {
+                continue;
+            }
+
+            glm::ivec3 lo = cell_of(proxy.aabb.min);
+            glm::ivec3 hi = cell_of(proxy.aabb.max);
+            glm::i64vec3 span = glm::i64vec3(hi) - glm::i64vec3(lo) + glm::i64vec3(1);
+            if (span.x * span.y * span.z > GRID_MAX_CELLS_PER_PROXY) {
+                out.oversized.push_back(p);
+                continue;
+            }
+
+            for (int32_t z = lo.z; z <= hi.z; z++) {
+                for (int32_t y = lo.y; y <= hi.y; y++) {
+                    for (int32_t x = lo.x; x <= hi.x; x++) {
+                        out.cells.push_back((uint64_t(cell_hash(glm::ivec3(x, y, z))) << 32) | p);
+                    }
+                }
+            }
+        }
+    });
+
+    m_cells.clear();
+    m_oversized.clear();
+    for (const ChunkCells& out : m_chunk_cells) {
+        m_cells.insert(m_cells.end(), out.cells.begin(), out.cells.end());
+        m_oversized.insert(m_oversized.end(), out.oversized.begin(), out.oversized.end());
+    }
+    std::sort(m_cells.begin(), m_cells.end());
+
+    // Proxies in two cells sharing a hash show up twice in a row
+    m_cells.erase(std::unique(m_cells.begin(), m_cells.end()), m_cells.end());
+
+    m_runs.clear();
+    for (uint32_t i = 0; i < m_cells.size(); i++) {
+        if (i == 0 || (m_cells[i] >> 32) != (m_cells[i - 1] >> 32)) {
+            m_runs.push_back(i);
+        }
+    }
+    uint32_t run_count = static_cast<uint32_t>(m_runs.size());
+    m_runs.push_back(static_cast<uint32_t>(m_cells.size()));
+
+    // Pairs per cell, plus every oversized proxy against all the others
+    uint32_t tasks = run_count + static_cast<uint32_t>(m_oversized.size());
+    m_chunk_pairs.resize(parallel_chunks(tasks, GRID_PARALLEL_GRAIN));
+    parallel_for(tasks, GRID_PARALLEL_GRAIN, [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+        std::vector<BroadphasePair>& out = m_chunk_pairs[chunk];
+        out.clear();
+
+        for (uint32_t t = begin; t < end; t++) {
+            if (t >= run_count) {
+                ProxyID a = m_oversized[t - run_count];
+                for (ProxyID b = 0; b < count; b++) {
+                    if (b == a || !m_proxies[b].alive) {
+                        continue;
+                    }
+
+                    // Two oversized proxies: only the lower one reports the pair
+                    bool b_oversized = std::binary_search(m_oversized.begin(), m_oversized.end(), b);
+                    if (b_oversized && b < a) {
+                        continue;
+                    }
+
+                    if (can_pair(a, b) && aabb_overlap(m_proxies[a].aabb, m_proxies[b].aabb)) {
+                        out.push_back(BroadphasePair{std::min(a, b), std::max(a, b)});
+                    }
+                }
+                continue;
+            }
+
+            uint32_t hash = static_cast<uint32_t>(m_cells[m_runs[t]] >> 32);
+            for (uint32_t i = m_runs[t]; i < m_runs[t + 1]; i++) {
+                ProxyID a = static_cast<ProxyID>(m_cells[i]);
+                const AABB& A = m_proxies[a].aabb;
+
+                for (uint32_t j = i + 1; j < m_runs[t + 1]; j++) {
+                    ProxyID b = static_cast<ProxyID>(m_cells[j]);
+                    const AABB& B = m_proxies[b].aabb;
+                    if (!can_pair(a, b) || !aabb_overlap(A, B)) {
+                        continue;
+                    }
+
+                    // The pair belongs to the cell of the intersection's min corner
+                    if (cell_hash(cell_of(glm::max(A.min, B.min))) == hash) {
+                        out.push_back(BroadphasePair{a, b});
+                    }
+                }
+            }
+        }
+    });
+
+    m_pairs.begin_rebuild();
+    for (const std::vector<BroadphasePair>& out : m_chunk_pairs) {
+        for (const BroadphasePair& pair : out) {
+            m_pairs.add(pair.a, pair.b);
+        }
+    }
+    m_pairs.end_rebuild();
+}
+
+float GridBroadphase::compute_cell_size() const {
+    double sum = 0.0;
+    uint32_t n = 0;
+    for (const Proxy& p : m_proxies) {
+        if (p.alive) {
+            glm::vec3 d = p.aabb.max - p.aabb.min;
+            sum += std::max(d.x, std::max(d.y, d.z));
+            n++;
+        }
+    }
+
+    float mean = n > 0 ? static_cast<float>(sum / n) : 1.0f;
+    return mean > 0.0f ? mean * GRID_AUTO_CELL_SCALE : 1.0f;
+}
+
+glm::ivec3 GridBroadphase::cell_of(const glm::vec3& p) const {
+    glm::vec3 c = glm::clamp(glm::floor(p / m_cell_size), -GRID_COORD_LIMIT, GRID_COORD_LIMIT);
+    return glm::ivec3(c);
+}
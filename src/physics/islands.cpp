@@ -0,0 +1,65 @@
+#include "physics/islands.h"
+
+#include <numeric>
+#include <utility>
+
+void Islands::reset(uint32_t count) {
+    m_parent.resize(count);
+    std::iota(m_parent.begin(), m_parent.end(), 0u);
+    m_size.assign(count, 1);
+    m_island.clear();
+    m_bodies.clear();
+    m_offsets.assign(1, 0);
+}
+
+// Path halving, every visited body skips to its grandparent
+uint32_t Islands::find(uint32_t i) {
+    while (m_parent[i] != i) {
+        m_parent[i] = m_parent[m_parent[i]];
+        i = m_parent[i];
+    }
+    return i;
+}
+
+// Union by size keeps the trees shallow
+void Islands::link(uint32_t a, uint32_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+        return;
+    }
+
+    if (m_size[a] < m_size[b]) {
+        std::swap(a, b);
+    }
+    m_parent[b] = a;
+    m_size[a] += m_size[b];
+}
+
+void Islands::build() {
+    uint32_t count = static_cast<uint32_t>(m_parent.size());
+
+    // Islands are numbered in the order of their lowest body, counted then laid out
+    m_island.resize(count);
+    m_offsets.assign(1, 0);
+    m_scratch.assign(count, UINT32_MAX);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t root = find(i);
+        if (m_scratch[root] == UINT32_MAX) {
+            m_scratch[root] = static_cast<uint32_t>(m_offsets.size()) - 1;
+            m_offsets.push_back(0);
+        }
+        m_island[i] = m_scratch[root];
+        m_offsets[m_island[i] + 1]++;
+    }
+
+    for (uint32_t k = 1; k < m_offsets.size(); k++) {
+        m_offsets[k] += m_offsets[k - 1];
+    }
+
+    m_bodies.resize(count);
+    m_scratch.assign(m_offsets.begin(), m_offsets.end() - 1);
+    for (uint32_t i = 0; i < count; i++) {
+        m_bodies[m_scratch[m_island[i]]++] = i;
+    }
+}
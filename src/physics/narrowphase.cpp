@@ -0,0 +1,886 @@
+#include "physics/narrowphase.h"
+#include "physics/simd.h"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+
+bool sphere_vs_sphere(EntityID a, const WorldSphere& A, EntityID b, const WorldSphere& B, Contact& out) {
+    glm::vec3 d = B.center - A.center;
+    float dist2 = dot(d, d);
+    float rsum = A.radius + B.radius;
+    if (dist2 >= rsum * rsum) {
+        return false;
+    }
+    // Use sqrt over dist2 since glm::lenght does the same
+    float dist = sqrt(std::max(dist2, COL_EPS));
+
+    out.a = a;
+    out.b = b;
+    out.normal = (dist > COL_EPS) ? (d / dist) : glm::vec3(1, 0, 0);
+    out.penetration = rsum - dist;
+    out.position = A.center + out.normal * (A.radius - out.penetration * 0.5f);
+    out.is_trigger = false;
+    out.points[0] = ContactPoint{out.position, out.penetration, 0};
+    out.point_count = 1;
+    return true;
+}
+
+bool sphere_vs_obb(EntityID a, const WorldSphere& s, EntityID b, const WorldOBB& obb, Contact& out) {
+    // Find closest point on WorldOBB to sphere center
+    // Transform sphere center into WorldOBB local space: local = rot_mat^t * (point - center)
+    glm::mat3 rot_mat(obb.axes[0], obb.axes[1], obb.axes[2]);
+    glm::vec3 local = transpose(rot_mat) * (s.center - obb.center);
+    glm::vec3 clamped = clamp(local, -obb.half_extents, obb.half_extents);
+    glm::vec3 closest = rot_mat * clamped + obb.center;
+    glm::vec3 d = closest - s.center;
+    float dist2 = dot(d, d);
+    if (dist2 > s.radius * s.radius) {
+        return false;
+    }
+
+    float dist = sqrt(std::max(dist2, COL_EPS));
+
+    out.a = a;
+    out.b = b;
+    out.normal = (dist > COL_EPS) ? (d / dist) : glm::vec3(1, 0, 0);
+    out.penetration = s.radius - dist;
+    out.position = closest;
+    out.is_trigger = false;
+    out.points[0] = ContactPoint{out.position, out.penetration, 0};
+    out.point_count = 1;
+    return true;
+}
+
+// Polygon vertex while clipping. `edge` labels the line the polygon follows from this vertex
+// on: incident face edges are 0-3, reference side planes 4-7
+struct ClipVertex {
+    glm::vec3 position;
+    uint32_t feature;
+    uint32_t edge;
+};
+
+#define CLIP_MAX_VERTICES 8
+#define OBB_FEATURE_BIAS 0.95f  // an edge axis or B face must be this much shallower to be preferred
+#define OBB_FEATURE_SLOP 1e-5f
+
+// Keeps the part of the polygon with dot(n, p) <= d
+static uint32_t clip_polygon(const ClipVertex* in, uint32_t count, const glm::vec3& n, float d, uint32_t plane,
+                             ClipVertex* out) {
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const ClipVertex& v0 = in[i];
+        const ClipVertex& v1 = in[(i + 1) % count];
+        float d0 = dot(n, v0.position) - d;
+        float d1 = dot(n, v1.position) - d;
+
+        if (d0 <= 0.0f) {
+            out[k++] = v0;
+        }
+
+        if ((d0 <= 0.0f) != (d1 <= 0.0f)) {
+            // New vertex where the line v0 follows crosses the plane, named after both
+            float t = d0 / (d0 - d1);
+            uint32_t feature = 4 + v0.edge * 4 + plane;
+            uint32_t edge = d0 <= 0.0f ? 4 + plane : v0.edge;  // leaving: follow the plane
+            out[k++] = ClipVertex{v0.position + (v1.position - v0.position) * t, feature, edge};
+        }
+    }
+    return k;
+}
+
+// Picks up to 4 points spanning the largest area: the deepest, the farthest from it,
+// then the farthest on each side of the line they form
+static uint32_t reduce_points(ContactPoint* pts, uint32_t count, const glm::vec3& normal, ContactPoint* out) {
+    if (count <= CONTACT_MAX_POINTS) {
+        std::copy(pts, pts + count, out);
+        return count;
+    }
+
+    uint32_t chosen[4] = {0, 0, 0, 0};
+    for (uint32_t i = 1; i < count; i++) {
+        if (pts[i].penetration > pts[chosen[0]].penetration) {
+            chosen[0] = i;
+        }
+    }
+
+    float best = -1.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        glm::vec3 d = pts[i].position - pts[chosen[0]].position;
+        if (dot(d, d) > best) {
+            best = dot(d, d);
+            chosen[1] = i;
+        }
+    }
+
+    glm::vec3 p0 = pts[chosen[0]].position;
+    glm::vec3 edge = pts[chosen[1]].position - p0;
+    float max_area = 0.0f;
+    float min_area = 0.0f;
+    chosen[2] = chosen[0];
+    chosen[3] = chosen[1];
+    for (uint32_t i = 0; i < count; i++) {
+        float area = dot(cross(edge, pts[i].position - p0), normal);
+        if (area > max_area) {
+            max_area = area;
+            chosen[2] = i;
+        }
+        if (area < min_area) {
+            min_area = area;
+            chosen[3] = i;
+        }
+    }
+
+    uint32_t k = 0;
+    for (uint32_t c = 0; c < 4; c++) {
+        if (std::find(chosen, chosen + c, chosen[c]) == chosen + c) {
+            out[k++] = pts[chosen[c]];
+        }
+    }
+    return k;
+}
+
+// Face contact: ref_n is the reference face normal pointing at the incident box.
+// Points lie halfway between the incident face and the reference face
+static uint32_t clip_faces(const WorldOBB& ref, uint32_t ref_axis, const WorldOBB& inc, const glm::vec3& ref_n,
+                           bool ref_is_b, ContactPoint* out) {
+    float ref_sign = dot(ref.axes[ref_axis], ref_n) > 0.0f ? 1.0f : -1.0f;
+
+    // Incident face: the one most anti-parallel to the reference normal
+    uint32_t inc_axis = 0;
+    float best = -1.0f;
+    for (uint32_t k = 0; k < 3; k++) {
+        float d = std::abs(dot(inc.axes[k], ref_n));
+        if (d > best) {
+            best = d;
+            inc_axis = k;
+        }
+    }
+    float inc_sign = dot(inc.axes[inc_axis], ref_n) > 0.0f ? -1.0f : 1.0f;
+
+    ClipVertex buffers[2][CLIP_MAX_VERTICES];
+    {
+        uint32_t u = (inc_axis + 1) % 3;
+        uint32_t v = (inc_axis + 2) % 3;
+        glm::vec3 c = inc.center + inc.axes[inc_axis] * (inc_sign * inc.half_extents[inc_axis]);
+        glm::vec3 du = inc.axes[u] * inc.half_extents[u];
+        glm::vec3 dv = inc.axes[v] * inc.half_extents[v];
+        buffers[0][0] = ClipVertex{c + du + dv, 0, 0};
+        buffers[0][1] = ClipVertex{c - du + dv, 1, 1};
+        buffers[0][2] = ClipVertex{c - du - dv, 2, 2};
+        buffers[0][3] = ClipVertex{c + du - dv, 3, 3};
+    }
+
+    // Side planes of the reference face
+    uint32_t count = 4;
+    uint32_t current = 0;
+    for (uint32_t plane = 0; plane < 4 && count > 0; plane++) {
+        uint32_t axis = (ref_axis + 1 + plane / 2) % 3;
+        glm::vec3 n = ref.axes[axis] * ((plane & 1) ? -1.0f : 1.0f);
+        float d = dot(n, ref.center) + ref.half_extents[axis];
+        count = clip_polygon(buffers[current], count, n, d, plane, buffers[current ^ 1]);
+        current ^= 1;
+    }
+
+    // Keep what is below the reference face
+    uint32_t face_id = (ref_is_b ? 1u << 24 : 0u) | ((ref_axis * 2 + (ref_sign < 0.0f)) << 16) |
+                       ((inc_axis * 2 + (inc_sign < 0.0f)) << 8);
+    glm::vec3 face_center = ref.center + ref.axes[ref_axis] * (ref_sign * ref.half_extents[ref_axis]);
+
+    ContactPoint candidates[CLIP_MAX_VERTICES];
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const ClipVertex& cv = buffers[current][i];
+        float separation = dot(cv.position - face_center, ref_n);
+        if (separation <= 0.0f) {
+            candidates[kept++] = ContactPoint{cv.position - ref_n * (separation * 0.5f), -separation, face_id | cv.feature};
+        }
+    }
+
+    return reduce_points(candidates, kept, ref_n, out);
+}
+
+// Edge-edge contact: one point halfway between the closest points of the two edges
+static uint32_t edge_contact(const WorldOBB& A, uint32_t axis_a, const WorldOBB& B, uint32_t axis_b,
+                             const glm::vec3& normal, ContactPoint* out) {
+    // The edges are the ones furthest along the normal on A and against it on B
+    uint32_t signs_a = 0;
+    uint32_t signs_b = 0;
+    glm::vec3 pa = A.center;
+    glm::vec3 pb = B.center;
+    for (uint32_t k = 0; k < 3; k++) {
+        if (k != axis_a) {
+            bool positive = dot(A.axes[k], normal) > 0.0f;
+            pa += A.axes[k] * (positive ? A.half_extents[k] : -A.half_extents[k]);
+            signs_a |= uint32_t(positive) << k;
+        }
+        if (k != axis_b) {
+            bool positive = dot(B.axes[k], normal) < 0.0f;
+            pb += B.axes[k] * (positive ? B.half_extents[k] : -B.half_extents[k]);
+            signs_b |= uint32_t(positive) << k;
+        }
+    }
+
+    // Closest points of the two segments
+    glm::vec3 da = A.axes[axis_a];
+    glm::vec3 db = B.axes[axis_b];
+    glm::vec3 r = pa - pb;
+    float b = dot(da, db);
+    float c = dot(da, r);
+    float f = dot(db, r);
+    float denom = 1.0f - b * b;
+
+    float s = denom > COL_EPS ? (b * f - c) / denom : 0.0f;
+    s = std::clamp(s, -A.half_extents[axis_a], A.half_extents[axis_a]);
+    float t = std::clamp(b * s + f, -B.half_extents[axis_b], B.half_extents[axis_b]);
+    s = std::clamp(b * t - c, -A.half_extents[axis_a], A.half_extents[axis_a]);
+
+    glm::vec3 ca = pa + da * s;
+    glm::vec3 cb = pb + db * t;
+
+    uint32_t feature = (1u << 31) | (axis_a << 20) | (axis_b << 16) | (signs_a << 8) | signs_b;
+    out[0] = ContactPoint{(ca + cb) * 0.5f, 0.0f, feature};
+    return 1;
+}
+
+bool obb_vs_obb(EntityID a, const WorldOBB& A, EntityID b, const WorldOBB& B, Contact& out) {
+    // Compute rotation matrix expressing B in A's local frame: rot_mat = rot_mat_A^t * rot_mat_B
+    glm::mat3 rot_mat_A(A.axes[0], A.axes[1], A.axes[2]);
+    glm::mat3 rot_mat_B(B.axes[0], B.axes[1], B.axes[2]);
+
+    glm::mat3 rot_mat = glm::transpose(rot_mat_A) * rot_mat_B;
+
+    // Translation from A to B in world space, then express in A's frame
+    glm::vec3 t_world = B.center - A.center;
+    glm::vec3 t = transpose(rot_mat_A) * t_world;  // t in A's local coords
+
+    // Compute common subexpressions abs(rot_mat) + COL_EPS
+    glm::mat3 abs_R;
+    for (int32_t i = 0; i < 3; ++i) {
+        for (int32_t j = 0; j < 3; ++j) {
+            abs_R[i][j] = std::abs(rot_mat[i][j]) + COL_EPS;
+        }
+    }
+
+    // World axes of both boxes, computed once with the same product as rot_mat * unit axis
+    // so every result stays bit for bit the same
+    glm::vec3 axes_A[3];
+    glm::vec3 axes_B[3];
+    for (int32_t k = 0; k < 3; ++k) {
+        glm::vec3 unit((k == 0), (k == 1), (k == 2));
+        axes_A[k] = rot_mat_A * unit;
+        axes_B[k] = rot_mat_B * unit;
+    }
+
+    // half extents
+    glm::vec3 a_he = A.half_extents;
+    glm::vec3 b_he = B.half_extents;
+
+    // Test the 15 axes and find the minimal penetration axis of each kind: faces of A,
+    // faces of B and edge pairs
+    float min_overlap[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    glm::vec3 min_axis[3] = {glm::vec3(1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(1, 0, 0)};
+    uint32_t min_index[3] = {0, 3, 6};  // 0-2 faces of A, 3-5 faces of B, 6-14 edge pairs
+    uint32_t index = 0;
+
+    auto test_axis = [&](const glm::vec3& axis_world, float proj_a, float proj_b, float dist_along_axis) -> bool {
+        uint32_t axis_index = index++;
+        float overlap = proj_a + proj_b - std::abs(dist_along_axis);
+        if (overlap < 0.0f) {
+            return false;
+        }
+
+        uint32_t kind = axis_index < 3 ? 0 : (axis_index < 6 ? 1 : 2);
+        if (overlap < min_overlap[kind]) {
+            min_overlap[kind] = overlap;
+            min_axis[kind] = axis_world;
+            min_index[kind] = axis_index;
+        }
+
+        return true;
+    };
+
+    // Test axes L0, L1, L2 (A's local axes). glm is column major: rot_mat[j][i] = dot(A_i, B_j)
+    // For A frame i: proj_a = a_he[i]
+    // For B frame onto A axis: proj_b = sum_j (b_he[j] * abs_R[j][i])
+    for (int32_t i = 0; i < 3; ++i) {
+        float proj_a = a_he[i];
+        float proj_b = b_he[0] * abs_R[0][i] + b_he[1] * abs_R[1][i] + b_he[2] * abs_R[2][i];
+        float dist = t[i];  // projection of t onto A's axis i (since t is in A frame)
+        if (!test_axis(axes_A[i], proj_a, proj_b, dist)) {
+            return false;
+        }
+    }
+
+    // Test axes M0, M1, M2 (B's local axes)
+    // For A frame onto B axis: proj_a = sum_i (a_he[i] * abs_R[j][i])
+    // For B frame j = proj_b = b_he[j]
+    for (int32_t j = 0; j < 3; ++j) {
+        float proj_a = a_he[0] * abs_R[j][0] + a_he[1] * abs_R[j][1] + a_he[2] * abs_R[j][2];
+        float proj_b = b_he[j];
+        // distance = dot(t, column j of rot_mat) -> since t is A-frame coords, that's B_j in A's frame
+        float dist = t[0] * rot_mat[j][0] + t[1] * rot_mat[j][1] + t[2] * rot_mat[j][2];
+        if (!test_axis(axes_B[j], proj_a, proj_b, dist)) {
+            return false;
+        }
+    }
+
+    // Test cross product axes (9 tests)
+    for (int32_t i = 0; i < 3; ++i) {
+        for (int32_t j = 0; j < 3; ++j) {
+            // axis = A_i x B_j (expressed in world)
+            glm::vec3 axis_world = cross(axes_A[i], axes_B[j]);
+            float axis_len2 = dot(axis_world, axis_world);
+
+            if (axis_len2 < COL_EPS) {
+                index++;
+                continue;
+            }
+
+            glm::vec3 axis = normalize(axis_world);
+
+            float proj_a = 0.0f;
+            float proj_b = 0.0f;
+            for (int32_t k = 0; k < 3; k++) {
+                proj_a += a_he[k] * std::abs(dot(axes_A[k], axis));
+            }
+            for (int32_t k = 0; k < 3; k++) {
+                proj_b += b_he[k] * std::abs(dot(axes_B[k], axis));
+            }
+
+            float dist = dot(t_world, axis);
+            if (!test_axis(axis, proj_a, proj_b, dist)) {
+                return false;
+            }
+        }
+    }
+
+    // Faces of A, then faces of B, then edges unless the next kind is clearly shallower.
+    // Rounding alone must not flip the reference feature of a resting contact
+    uint32_t kind = 0;
+    for (uint32_t k = 1; k < 3; k++) {
+        if (min_overlap[k] < min_overlap[kind] * OBB_FEATURE_BIAS - OBB_FEATURE_SLOP) {
+            kind = k;
+        }
+    }
+    glm::vec3 normal = min_axis[kind];
+
+    // Use min_axis (in world space) as approximate contact normal
+    glm::vec3 center_dir = B.center - A.center;
+    if (dot(center_dir, normal) < 0.0f) {
+        normal = -normal;
+    }
+
+    out.a = a;
+    out.b = b;
+    out.normal = normalize(normal);
+    out.penetration = min_overlap[kind];
+    out.is_trigger = false;
+
+    if (kind == 0) {
+        // Clip the incident face against the reference face
+        out.point_count = clip_faces(A, min_index[0], B, out.normal, false, out.points);
+    } else if (kind == 1) {
+        out.point_count = clip_faces(B, min_index[1] - 3, A, -out.normal, true, out.points);
+    } else {
+        uint32_t edges = min_index[2] - 6;
+        out.point_count = edge_contact(A, edges / 3, B, edges % 3, out.normal, out.points);
+        out.points[0].penetration = out.penetration;
+    }
+
+    if (out.point_count == 0) {
+        // Clipping lost every point to rounding, fall back to one approximate point
+        // midway between centers shifted by half penetration along normal
+        out.points[0] =
+            ContactPoint{(A.center + B.center) * 0.5f - out.normal * (out.penetration * 0.5f), out.penetration};
+        out.point_count = 1;
+    }
+
+    out.position = glm::vec3(0.0f);
+    for (uint32_t i = 0; i < out.point_count; i++) {
+        out.position += out.points[i].position;
+    }
+    out.position /= static_cast<float>(out.point_count);
+    return true;
+}
+
+// Contact of two spheres at the closest points of the shapes' cores
+static bool core_contact(EntityID a, const glm::vec3& pa, float ra, EntityID b, const glm::vec3& pb, float rb,
+                         Contact& out) {
+    glm::vec3 d = pb - pa;
+    float dist2 = dot(d, d);
+    float rsum = ra + rb;
+    if (dist2 >= rsum * rsum) {
+        return false;
+    }
+
+    float dist = sqrt(std::max(dist2, COL_EPS));
+
+    out.a = a;
+    out.b = b;
+    out.normal = (dist > COL_EPS) ? (d / dist) : glm::vec3(1, 0, 0);
+    out.penetration = rsum - dist;
+    out.position = pa + out.normal * (ra - out.penetration * 0.5f);
+    out.is_trigger = false;
+    out.points[0] = ContactPoint{out.position, out.penetration, 0};
+    out.point_count = 1;
+    return true;
+}
+
+// Closest points of segments p0-p1 and q0-q1 (Ericson, Real-Time Collision Detection 5.1.9)
+static void closest_points_of_segments(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& q0,
+                                       const glm::vec3& q1, glm::vec3& cp, glm::vec3& cq) {
+    glm::vec3 d1 = p1 - p0;
+    glm::vec3 d2 = q1 - q0;
+    glm::vec3 r = p0 - q0;
+    float a = dot(d1, d1);
+    float e = dot(d2, d2);
+    float f = dot(d2, r);
+
+    float s = 0.0f;
+    float t = 0.0f;
+    if (a <= COL_EPS && e <= COL_EPS) {
+        // Both degenerate to points
+    } else if (a <= COL_EPS) {
+        t = std::clamp(f / e, 0.0f, 1.0f);
+    } else {
+        float c = dot(d1, r);
+        if (e <= COL_EPS) {
+            s = std::clamp(-c / a, 0.0f, 1.0f);
+        } else {
+            // Parallel segments have no unique pair, any s works
+            float b = dot(d1, d2);
+            float denom = a * e - b * b;
+            s = denom > COL_EPS * a * e ? std::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+            t = (b * s + f) / e;
+
+            if (t < 0.0f) {
+                t = 0.0f;
+                s = std::clamp(-c / a, 0.0f, 1.0f);
+            } else if (t > 1.0f) {
+                t = 1.0f;
+                s = std::clamp((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+    }
+
+    cp = p0 + d1 * s;
+    cq = q0 + d2 * t;
+}
+
+bool sphere_vs_capsule(EntityID a, const WorldSphere& s, EntityID b, const WorldCapsule& cap, Contact& out) {
+    glm::vec3 core = closest_point_on_segment(cap.p0, cap.p1, s.center);
+    return core_contact(a, s.center, s.radius, b, core, cap.radius, out);
+}
+
+bool capsule_vs_capsule(EntityID a, const WorldCapsule& A, EntityID b, const WorldCapsule& B, Contact& out) {
+    glm::vec3 core_a, core_b;
+    closest_points_of_segments(A.p0, A.p1, B.p0, B.p1, core_a, core_b);
+    return core_contact(a, core_a, A.radius, b, core_b, B.radius, out);
+}
+
+bool capsule_vs_obb(EntityID a, const WorldCapsule& cap, EntityID b, const WorldOBB& obb, Contact& out) {
+    // The squared distance from the segment to the box is convex along the segment,
+    // so bisecting on the sign of its slope finds the closest segment point
+    glm::vec3 axis = cap.p1 - cap.p0;
+    auto slope = [&](float t) {
+        glm::vec3 p = cap.p0 + axis * t;
+        return dot(p - closest_point_on_obb(obb, p), axis);
+    };
+
+    float t = 0.0f;
+    if (slope(0.0f) < 0.0f) {
+        if (slope(1.0f) <= 0.0f) {
+            t = 1.0f;
+        } else {
+            float lo = 0.0f;
+            float hi = 1.0f;
+            for (uint32_t i = 0; i < CAPSULE_OBB_ITERATIONS; i++) {
+                float mid = (lo + hi) * 0.5f;
+                (slope(mid) < 0.0f ? lo : hi) = mid;
+            }
+            t = (lo + hi) * 0.5f;
+        }
+    }
+
+    glm::vec3 p = cap.p0 + axis * t;
+    glm::vec3 q = closest_point_on_obb(obb, p);
+    glm::vec3 d = q - p;
+    float dist2 = dot(d, d);
+    if (dist2 > cap.radius * cap.radius) {
+        return false;
+    }
+
+    out.a = a;
+    out.b = b;
+    out.is_trigger = false;
+
+    if (dist2 > COL_EPS) {
+        float dist = sqrt(dist2);
+        out.normal = d / dist;
+        out.penetration = cap.radius - dist;
+        out.position = q;
+    } else {
+        // The segment goes through the box: push the capsule out through the face
+        // that needs the least travel
+        float best = FLT_MAX;
+        for (uint32_t k = 0; k < 3; k++) {
+            float l0 = dot(cap.p0 - obb.center, obb.axes[k]);
+            float l1 = dot(cap.p1 - obb.center, obb.axes[k]);
+            float to_positive = obb.half_extents[k] - std::min(l0, l1);
+            float to_negative = std::max(l0, l1) + obb.half_extents[k];
+
+            if (to_positive < best) {
+                best = to_positive;
+                out.normal = -obb.axes[k];
+            }
+            if (to_negative < best) {
+                best = to_negative;
+                out.normal = obb.axes[k];
+            }
+        }
+        out.penetration = best + cap.radius;
+        out.position = p;
+    }
+
+    out.points[0] = ContactPoint{out.position, out.penetration, 0};
+    out.point_count = 1;
+    return true;
+}
+
+bool convex_contact(EntityID a, const SupportShape& A, EntityID b, const SupportShape& B, Contact& out,
+                    GjkCache* cache) {
+    GjkSimplex simplex;
+    float dist;
+    glm::vec3 pa, pb;
+    glm::vec3 normal;
+    float depth;
+    float margins = A.margin + B.margin;
+
+    if (gjk_distance(A, B, simplex, dist, pa, pb, cache)) {
+        if (dist >= margins) {
+            return false;
+        }
+        normal = (pb - pa) / dist;
+        depth = margins - dist;
+    } else if (epa_penetration(A, B, simplex, normal, depth, pa, pb)) {
+        depth += margins;
+    } else {
+        // Flat Minkowski difference, e.g. a sphere centered on a triangle's plane: push
+        // out of a triangle through its front
+        pa = A.center();
+        pb = B.center();
+        glm::vec3 d = B.kind == SupportKind::Triangle
+                          ? -glm::cross(B.points[1] - B.points[0], B.points[2] - B.points[0])
+                          : pb - pa;
+        normal = dot(d, d) > COL_EPS ? glm::normalize(d) : glm::vec3(1, 0, 0);
+        depth = margins;
+    }
+
+    pa += normal * A.margin;
+    pb -= normal * B.margin;
+
+    out.a = a;
+    out.b = b;
+    out.normal = normal;
+    out.penetration = depth;
+    out.position = (pa + pb) * 0.5f;
+    out.is_trigger = false;
+    out.points[0] = ContactPoint{out.position, out.penetration, 0};
+    out.point_count = 1;
+    return true;
+}
+
+bool convex_overlap(const SupportShape& A, const SupportShape& B) {
+    GjkSimplex simplex;
+    float dist;
+    glm::vec3 pa, pb;
+    return !gjk_distance(A, B, simplex, dist, pa, pb) || dist < A.margin + B.margin;
+}
+
+// Feature ids of mesh contact points: the triangle, then a flag and the shape vertex for face contacts
+#define MESH_FEATURE_SHIFT 9
+#define MESH_FEATURE_VERTEX 256u
+
+uint32_t shape_vs_mesh(EntityID a, const SupportShape& A, const AABB& a_aabb, EntityID b, const WorldMesh& mesh,
+                       std::vector<Contact>& out, MeshScratch& scratch) {
+    AABB local = transform_aabb(a_aabb, glm::mat3(mesh.inverse), glm::vec3(mesh.inverse[3]));
+
+    scratch.points.clear();
+    mesh.mesh->query(local, [&](uint32_t t) {
+        glm::vec3 ta, tb, tc;
+        mesh.triangle(t, ta, tb, tc);
+
+        Contact c;
+        if (!convex_contact(a, A, b, SupportShape::triangle(ta, tb, tc), c)) {
+            return;
+        }
+
+        // Boxes and hulls lying on a triangle touch it with a whole face. GJK only gives
+        // one point, their vertices past the triangle's plane and over it are a stable manifold
+        size_t before = scratch.points.size();
+        glm::vec3 tri_n = cross(tb - ta, tc - ta);
+        float len = glm::length(tri_n);
+        if ((A.kind == SupportKind::Box || A.kind == SupportKind::Hull) && len > COL_EPS) {
+            tri_n /= len;
+            float facing = dot(c.normal, tri_n);
+            if (std::abs(facing) > MESH_FACE_COS) {
+                glm::vec3 n = facing > 0.0f ? tri_n : -tri_n;
+                uint32_t count = A.kind == SupportKind::Box ? 8 : A.convex->hull->vertex_count();
+                for (uint32_t i = 0; i < count; i++) {
+                    glm::vec3 v = A.vertex(i);
+                    float depth = dot(v - ta, n);
+                    if (depth <= 0.0f) {
+                        continue;
+                    }
+
+                    glm::vec3 on_plane = v - n * depth;
+                    float weights[3];
+                    glm::vec3 q = closest_point_on_triangle(ta, tb, tc, on_plane, weights);
+                    if (dot(q - on_plane, q - on_plane) > COL_EPS) {
+                        continue;
+                    }
+
+                    uint32_t feature = (t << MESH_FEATURE_SHIFT) | MESH_FEATURE_VERTEX | i;
+                    scratch.points.push_back(
+                        MeshContactPoint{n, ContactPoint{(v + on_plane) * 0.5f, depth, feature}, 0});
+                }
+            }
+        }
+
+        if (scratch.points.size() == before) {
+            scratch.points.push_back(
+                MeshContactPoint{c.normal, ContactPoint{c.position, c.penetration, t << MESH_FEATURE_SHIFT}, 0});
+        }
+    });
+
+    if (scratch.points.empty()) {
+        return 0;
+    }
+
+    // Deepest first, so each manifold takes the normal of its deepest point
+    std::sort(scratch.points.begin(), scratch.points.end(), [](const MeshContactPoint& x, const MeshContactPoint& y) {
+        return x.point.penetration > y.point.penetration;
+    });
+
+    size_t first = out.size();
+    for (MeshContactPoint& p : scratch.points) {
+        p.manifold = MESH_MAX_CONTACTS;
+        for (size_t k = first; k < out.size(); k++) {
+            if (dot(out[k].normal, p.normal) > MESH_NORMAL_COS) {
+                p.manifold = static_cast<uint32_t>(k - first);
+                break;
+            }
+        }
+
+        if (p.manifold == MESH_MAX_CONTACTS && out.size() - first < MESH_MAX_CONTACTS) {
+            p.manifold = static_cast<uint32_t>(out.size() - first);
+            Contact& c = out.emplace_back();
+            c.a = a;
+            c.b = b;
+            c.normal = p.normal;
+            c.penetration = p.point.penetration;
+            c.is_trigger = false;
+        }
+    }
+
+    uint32_t manifolds = static_cast<uint32_t>(out.size() - first);
+    for (uint32_t m = 0; m < manifolds; m++) {
+        scratch.manifold.clear();
+        for (const MeshContactPoint& p : scratch.points) {
+            if (p.manifold == m) {
+                scratch.manifold.push_back(p.point);
+            }
+        }
+
+        Contact& c = out[first + m];
+        c.point_count = reduce_points(scratch.manifold.data(), static_cast<uint32_t>(scratch.manifold.size()),
+                                      c.normal, c.points);
+        c.position = glm::vec3(0.0f);
+        for (uint32_t i = 0; i < c.point_count; i++) {
+            c.position += c.points[i].position;
+        }
+        c.position /= static_cast<float>(c.point_count);
+    }
+    return manifolds;
+}
+
+bool shape_overlaps_mesh(const SupportShape& A, const AABB& a_aabb, const WorldMesh& mesh) {
+    AABB local = transform_aabb(a_aabb, glm::mat3(mesh.inverse), glm::vec3(mesh.inverse[3]));
+
+    bool found = false;
+    mesh.mesh->query(local, [&](uint32_t t) {
+        if (found) {
+            return;
+        }
+
+        glm::vec3 ta, tb, tc;
+        mesh.triangle(t, ta, tb, tc);
+        found = convex_overlap(A, SupportShape::triangle(ta, tb, tc));
+    });
+    return found;
+}
+
+bool obb_axis_separates(const WorldOBB& A, const WorldOBB& B, uint32_t axis) {
+    glm::vec3 n;
+    if (axis < 3) {
+        n = A.axes[axis];
+    } else if (axis < 6) {
+        n = B.axes[axis - 3];
+    } else {
+        n = glm::cross(A.axes[(axis - 6) / 3], B.axes[(axis - 6) % 3]);
+        float len2 = glm::dot(n, n);
+        if (len2 < COL_EPS) {
+            return false;
+        }
+        n /= std::sqrt(len2);
+    }
+
+    // On a face axis obb_vs_obb() pads the other box's projection by COL_EPS
+    float pad_a = axis >= 3 && axis < 6 ? COL_EPS : 0.0f;
+    float pad_b = axis < 3 ? COL_EPS : 0.0f;
+    float proj_a = 0.0f;
+    float proj_b = 0.0f;
+    for (uint32_t k = 0; k < 3; k++) {
+        proj_a += A.half_extents[k] * (std::abs(glm::dot(A.axes[k], n)) + pad_a);
+        proj_b += B.half_extents[k] * (std::abs(glm::dot(B.axes[k], n)) + pad_b);
+    }
+    return proj_a + proj_b - std::abs(glm::dot(B.center - A.center, n)) < 0.0f;
+}
+
+// Separating axis test of V::WIDTH pairs starting at `first`. Every lane repeats the
+// operations of obb_vs_obb() in the same order, so the decision is identical. The
+// box axes are used directly instead of rot_mat * unit axis: the two only differ
+// in the sign of zero components, which no comparison below can see
+template <typename V>
+static void obb_sat_kernel(const std::array<std::vector<float>, 2 * ObbPairBatch::BOX_FIELDS>& fields, uint32_t first,
+                           uint8_t* axes) {
+    constexpr uint32_t B_OFFSET = ObbPairBatch::BOX_FIELDS;
+    auto field = [&](uint32_t f) { return V::load(fields[f].data() + first); };
+
+    V ca[3], cb[3], ha[3], hb[3], a[3][3], b[3][3];
+    for (uint32_t k = 0; k < 3; k++) {
+        ca[k] = field(k);
+        cb[k] = field(B_OFFSET + k);
+        ha[k] = field(3 + k);
+        hb[k] = field(B_OFFSET + 3 + k);
+        for (uint32_t r = 0; r < 3; r++) {
+            a[k][r] = field(6 + k * 3 + r);
+            b[k][r] = field(B_OFFSET + 6 + k * 3 + r);
+        }
+    }
+
+    V eps = V::set(COL_EPS);
+    V zero = V::set(0.0f);
+
+    V tw[3] = {cb[0] - ca[0], cb[1] - ca[1], cb[2] - ca[2]};
+
+    // rot[c][r] = dot(A axis r, B axis c), t = translation in A's frame
+    V rot[3][3];
+    V abs_r[3][3];
+    V t[3];
+    for (uint32_t c = 0; c < 3; c++) {
+        for (uint32_t r = 0; r < 3; r++) {
+            rot[c][r] = a[r][0] * b[c][0] + a[r][1] * b[c][1] + a[r][2] * b[c][2];
+            abs_r[c][r] = V::abs(rot[c][r]) + eps;
+        }
+        t[c] = a[c][0] * tw[0] + a[c][1] * tw[1] + a[c][2] * tw[2];
+    }
+
+    // Lanes already separated, each keeping the first axis that did it
+    uint32_t separated = 0;
+    uint8_t lane_axes[V::WIDTH];
+    std::fill(lane_axes, lane_axes + V::WIDTH, static_cast<uint8_t>(OBB_NO_AXIS));
+    auto record = [&](typename V::Mask sep, uint32_t axis) {
+        for (uint32_t fresh = V::bits(sep) & ~separated; fresh != 0; fresh &= fresh - 1) {
+            lane_axes[std::countr_zero(fresh)] = static_cast<uint8_t>(axis);
+        }
+        separated |= V::bits(sep);
+    };
+
+    // Face axes of A and B
+    for (uint32_t i = 0; i < 3; i++) {
+        V proj_b = hb[0] * abs_r[0][i] + hb[1] * abs_r[1][i] + hb[2] * abs_r[2][i];
+        record(V::lt(ha[i] + proj_b - V::abs(t[i]), zero), i);
+    }
+    for (uint32_t j = 0; j < 3; j++) {
+        V proj_a = ha[0] * abs_r[j][0] + ha[1] * abs_r[j][1] + ha[2] * abs_r[j][2];
+        V dist = t[0] * rot[j][0] + t[1] * rot[j][1] + t[2] * rot[j][2];
+        record(V::lt(proj_a + hb[j] - V::abs(dist), zero), 3 + j);
+    }
+
+    constexpr uint32_t ALL = (1u << V::WIDTH) - 1;
+    if (separated != ALL) {
+        // Edge-edge axes
+        for (uint32_t i = 0; i < 3; i++) {
+            for (uint32_t j = 0; j < 3; j++) {
+                V axis[3] = {a[i][1] * b[j][2] - b[j][1] * a[i][2], a[i][2] * b[j][0] - b[j][2] * a[i][0],
+                             a[i][0] * b[j][1] - b[j][0] * a[i][1]};
+                V len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+                typename V::Mask degenerate = V::lt(len2, eps);
+
+                V inv_len = V::set(1.0f) / V::sqrt(len2);
+                V n[3] = {axis[0] * inv_len, axis[1] * inv_len, axis[2] * inv_len};
+
+                V proj_a = zero;
+                V proj_b = zero;
+                for (uint32_t k = 0; k < 3; k++) {
+                    proj_a = proj_a + ha[k] * V::abs(a[k][0] * n[0] + a[k][1] * n[1] + a[k][2] * n[2]);
+                }
+                for (uint32_t k = 0; k < 3; k++) {
+                    proj_b = proj_b + hb[k] * V::abs(b[k][0] * n[0] + b[k][1] * n[1] + b[k][2] * n[2]);
+                }
+                V dist = tw[0] * n[0] + tw[1] * n[1] + tw[2] * n[2];
+
+                typename V::Mask sep_axis = V::lt(proj_a + proj_b - V::abs(dist), zero);
+                record(V::mask_andnot(degenerate, sep_axis), 6 + i * 3 + j);
+            }
+        }
+    }
+
+    std::copy(lane_axes, lane_axes + V::WIDTH, axes + first);
+}
+
+void ObbPairBatch::clear() {
+    for (std::vector<float>& f : m_fields) {
+        f.clear();
+    }
+}
+
+void ObbPairBatch::push(const WorldOBB& A, const WorldOBB& B) {
+    const WorldOBB* boxes[2] = {&A, &B};
+    for (uint32_t i = 0; i < 2; i++) {
+        const WorldOBB& box = *boxes[i];
+        uint32_t base = i * BOX_FIELDS;
+        for (uint32_t k = 0; k < 3; k++) {
+            m_fields[base + k].push_back(box.center[k]);
+            m_fields[base + 3 + k].push_back(box.half_extents[k]);
+            for (uint32_t r = 0; r < 3; r++) {
+                m_fields[base + 6 + k * 3 + r].push_back(box.axes[k][r]);
+            }
+        }
+    }
+}
+
+void ObbPairBatch::test(std::vector<uint8_t>& axes) const {
+    axes.resize(size());
+    test(0, size(), axes.data());
+}
+
+void ObbPairBatch::test(uint32_t begin, uint32_t end, uint8_t* axes) const {
+    uint32_t i = begin;
+#ifdef __AVX__
+    for (; i + F32x8::WIDTH <= end; i += F32x8::WIDTH) {
+        obb_sat_kernel<F32x8>(m_fields, i, axes);
+    }
+#endif
+#ifdef SIMD_HAS_SSE2
+    for (; i + F32x4::WIDTH <= end; i += F32x4::WIDTH) {
+        obb_sat_kernel<F32x4>(m_fields, i, axes);
+    }
+#endif
+    for (; i < end; i++) {
+        obb_sat_kernel<F32x1>(m_fields, i, axes);
+    }
+}
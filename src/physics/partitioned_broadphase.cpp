@@ -0,0 +1,135 @@
+#include "physics/partitioned_broadphase.h"
+
+PartitionedBroadphase::PartitionedBroadphase(std::unique_ptr<IBroadphase> dynamic) : m_dynamic(std::move(dynamic)) {
+}
+
+ProxyID PartitionedBroadphase::add_proxy(const AABB& aabb, EntityID entity, const ProxyFilter& filter) {
+    ProxyID p = alloc_proxy(aabb, entity, filter);
+
+    if (filter.is_static) {
+        ProxyID inner = m_static.add_proxy(aabb, entity, filter);
+        map(m_inner, p, inner);
+        map(m_static_outer, inner, p);
+        m_static_changed = true;
+    } else {
+        ProxyID inner = m_dynamic->add_proxy(aabb, entity, filter);
+        map(m_inner, p, inner);
+        map(m_dynamic_outer, inner, p);
+        mark_moved(p);
+    }
+
+    return p;
+}
+
+void PartitionedBroadphase::remove_proxy(ProxyID proxy) {
+    if (m_proxies[proxy].filter.is_static) {
+        m_static.remove_proxy(m_inner[proxy]);
+        m_static.clear_pair_changes();
+    } else {
+        m_dynamic->remove_proxy(m_inner[proxy]);
+        // Our own pairs go with free_proxy(), drop the inner removals so they aren't
+        // mapped onto a proxy reusing the id
+        m_dynamic->clear_pair_changes();
+        m_moved[proxy] = 0;
+    }
+
+    free_proxy(proxy);
+}
+
+void PartitionedBroadphase::move_proxy(ProxyID proxy, const AABB& aabb) {
+    AABB& current = m_proxies[proxy].aabb;
+    if (glm::all(glm::equal(current.min, aabb.min)) && glm::all(glm::equal(current.max, aabb.max))) {
+        return;
+    }
+
+    current = aabb;
+    if (m_proxies[proxy].filter.is_static) {
+        m_static.move_proxy(m_inner[proxy], aabb);
+        m_static_changed = true;
+    } else {
+        m_dynamic->move_proxy(m_inner[proxy], aabb);
+        mark_moved(proxy);
+    }
+}
+
+void PartitionedBroadphase::update_pairs() {
+    // Static proxies only pair with dynamic ones. move_proxy() already refit the static
+    // tree, a pair pass over it could never find anything
+    m_static.forget_moved();
+
+    // Dynamic vs dynamic, translated from the inner strategy's changes
+    m_dynamic->clear_pair_changes();
+    m_dynamic->update_pairs();
+    for (const BroadphasePair& pair : m_dynamic->pairs().removed()) {
+        m_pairs.remove(m_dynamic_outer[pair.a], m_dynamic_outer[pair.b]);
+    }
+    for (const BroadphasePair& pair : m_dynamic->pairs().added()) {
+        m_pairs.add(m_dynamic_outer[pair.a], m_dynamic_outer[pair.b]);
+    }
+
+    // Static vs dynamic, only where something moved
+    m_stale.clear();
+    for (const BroadphasePair& pair : m_pairs.pairs()) {
+        bool a_static = m_proxies[pair.a].filter.is_static;
+        bool b_static = m_proxies[pair.b].filter.is_static;
+        if (a_static == b_static) {
+            continue;
+        }
+
+        ProxyID dynamic = a_static ? pair.b : pair.a;
+        if ((m_static_changed || m_moved[dynamic]) && !aabb_overlap(m_proxies[pair.a].aabb, m_proxies[pair.b].aabb)) {
+            m_stale.push_back(pair);
+        }
+    }
+    for (const BroadphasePair& pair : m_stale) {
+        m_pairs.remove(pair.a, pair.b);
+    }
+
+    auto query_static = [&](ProxyID p) {
+        const AABB& aabb = m_proxies[p].aabb;
+        m_static.query(aabb, [&](ProxyID inner) {
+            ProxyID s = m_static_outer[inner];
+            if (can_pair(p, s) && aabb_overlap(aabb, m_proxies[s].aabb)) {
+                m_pairs.add(p, s);
+            }
+        });
+    };
+
+    if (m_static_changed) {
+        for (ProxyID p = 0; p < m_proxies.size(); p++) {
+            if (m_proxies[p].alive && !m_proxies[p].filter.is_static) {
+                query_static(p);
+            }
+        }
+    } else {
+        for (ProxyID p : m_moved_list) {
+            if (m_moved[p]) {
+                query_static(p);
+            }
+        }
+    }
+
+    for (ProxyID p : m_moved_list) {
+        m_moved[p] = 0;
+    }
+    m_moved_list.clear();
+    m_static_changed = false;
+}
+
+void PartitionedBroadphase::mark_moved(ProxyID proxy) {
+    if (proxy >= m_moved.size()) {
+        m_moved.resize(proxy + 1, 0);
+    }
+
+    if (!m_moved[proxy]) {
+        m_moved[proxy] = 1;
+        m_moved_list.push_back(proxy);
+    }
+}
+
+void PartitionedBroadphase::map(std::vector<ProxyID>& table, ProxyID from, ProxyID to) {
+    if (from >= table.size()) {
+        table.resize(from + 1, INVALID_PROXY);
+    }
+    table[from] = to;
+}
@@ -0,0 +1,140 @@
+#include "physics/sap_broadphase.h"
+
+#include <algorithm>
+
+// Ties put min endpoints first, so touching boxes count as overlapping like in aabb_overlap()
+static bool endpoint_less(float a_value, bool a_is_max, float b_value, bool b_is_max) {
+    return a_value < b_value || (a_value == b_value && !a_is_max && b_is_max);
+}
+
+ProxyID SAPBroadphase::add_proxy(const AABB& aabb, EntityID entity, const ProxyFilter& filter) {
+    ProxyID p = alloc_proxy(aabb, entity, filter);
+    m_pending_adds++;
+    if (p >= m_endpoint_index.size()) {
+        m_endpoint_index.resize(p + 1);
+    }
+
+    // Appended unsorted, the next update_pairs() sorts them in and reports their pairs
+    for (uint32_t k = 0; k < 3; k++) {
+        std::vector<Endpoint>& axis = m_axes[k];
+        m_endpoint_index[p][k] = static_cast<uint32_t>(axis.size());
+        axis.push_back(Endpoint{aabb.min[k], p << 1});
+        m_endpoint_index[p][k + 3] = static_cast<uint32_t>(axis.size());
+        axis.push_back(Endpoint{aabb.max[k], (p << 1) | 1});
+    }
+
+    return p;
+}
+
+void SAPBroadphase::remove_proxy(ProxyID proxy) {
+    for (uint32_t k = 0; k < 3; k++) {
+        std::vector<Endpoint>& axis = m_axes[k];
+        uint32_t lo = m_endpoint_index[proxy][k];
+        uint32_t hi = m_endpoint_index[proxy][k + 3];
+        if (lo > hi) {
+            std::swap(lo, hi);
+        }
+
+        axis.erase(axis.begin() + hi);
+        axis.erase(axis.begin() + lo);
+
+        // Shift the indices of the endpoints that moved down
+        for (uint32_t i = lo; i < axis.size(); i++) {
+            const Endpoint& ep = axis[i];
+            m_endpoint_index[ep.proxy()][ep.is_max() ? k + 3 : k] = i;
+        }
+    }
+
+    free_proxy(proxy);
+}
+
+void SAPBroadphase::move_proxy(ProxyID proxy, const AABB& aabb) {
+    m_proxies[proxy].aabb = aabb;
+    for (uint32_t k = 0; k < 3; k++) {
+        m_axes[k][m_endpoint_index[proxy][k]].value = aabb.min[k];
+        m_axes[k][m_endpoint_index[proxy][k + 3]].value = aabb.max[k];
+    }
+}
+
+void SAPBroadphase::update_pairs() {
+    // Insertion sort is quadratic for endpoints far from their place, so bulk
+    // additions (e.g. loading a scene) rebuild the lists instead
+    uint32_t live = static_cast<uint32_t>(m_axes[0].size() / 2);
+    if (m_pending_adds > SAP_REBUILD_MIN_ADDS && m_pending_adds * 4 > live) {
+        rebuild();
+    } else {
+        for (uint32_t k = 0; k < 3; k++) {
+            sort_axis(k);
+        }
+    }
+
+    m_pending_adds = 0;
+}
+
+void SAPBroadphase::rebuild() {
+    for (uint32_t k = 0; k < 3; k++) {
+        std::vector<Endpoint>& axis = m_axes[k];
+        std::sort(axis.begin(), axis.end(), [](const Endpoint& a, const Endpoint& b) {
+            return endpoint_less(a.value, a.is_max(), b.value, b.is_max());
+        });
+
+        for (uint32_t i = 0; i < axis.size(); i++) {
+            m_endpoint_index[axis[i].proxy()][axis[i].is_max() ? k + 3 : k] = i;
+        }
+    }
+
+    // Sweep x keeping the proxies whose interval is open
+    m_pairs.begin_rebuild();
+    std::vector<ProxyID> open;
+    for (const Endpoint& ep : m_axes[0]) {
+        ProxyID p = ep.proxy();
+        if (ep.is_max()) {
+            open.erase(std::find(open.begin(), open.end(), p));
+            continue;
+        }
+
+        for (ProxyID other : open) {
+            if (can_pair(p, other) && aabb_overlap(m_proxies[p].aabb, m_proxies[other].aabb)) {
+                m_pairs.add(p, other);
+            }
+        }
+        open.push_back(p);
+    }
+    m_pairs.end_rebuild();
+}
+
+void SAPBroadphase::sort_axis(uint32_t k) {
+    std::vector<Endpoint>& axis = m_axes[k];
+
+    for (uint32_t i = 1; i < axis.size(); i++) {
+        Endpoint moving = axis[i];
+        uint32_t j = i;
+
+        while (j > 0 && endpoint_less(moving.value, moving.is_max(), axis[j - 1].value, axis[j - 1].is_max())) {
+            const Endpoint& other = axis[j - 1];
+            ProxyID a = moving.proxy();
+            ProxyID b = other.proxy();
+
+            if (a != b) {
+                if (!moving.is_max() && other.is_max()) {
+                    // Min passes a max leftwards: they start overlapping on this axis
+                    if (can_pair(a, b) && aabb_overlap(m_proxies[a].aabb, m_proxies[b].aabb)) {
+                        m_pairs.add(a, b);
+                    }
+                } else if (moving.is_max() && !other.is_max()) {
+                    // Max passes a min leftwards: they stop overlapping
+                    m_pairs.remove(a, b);
+                }
+            }
+
+            axis[j] = other;
+            m_endpoint_index[b][other.is_max() ? k + 3 : k] = j;
+            j--;
+        }
+
+        if (j != i) {
+            axis[j] = moving;
+            m_endpoint_index[moving.proxy()][moving.is_max() ? k + 3 : k] = j;
+        }
+    }
+}
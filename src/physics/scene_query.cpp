@@ -0,0 +1,556 @@
+#include "physics/scene_query.h"
+#include "physics/broadphase.h"
+#include "physics/narrowphase.h"
+#include "physics/shape_cast.h"
+#include "core/thread_pool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define SQ_HAS_SSE2
+static_assert(SQ_PACKET_SIZE == 4, "packets are traversed in one SSE register");
+#endif
+
+// Rays of a packet in SoA layout. Inactive lanes have a negative tmax so no box accepts them
+struct RayPacket {
+    alignas(16) float origin[3][SQ_PACKET_SIZE];
+    alignas(16) float inv_dir[3][SQ_PACKET_SIZE];
+    alignas(16) float tmax[SQ_PACKET_SIZE];
+};
+
+// Huge instead of infinite for axis-parallel rays, so origins on a slab plane give no NaN
+static float safe_inverse(float d) {
+    return std::abs(d) > 1e-20f ? 1.0f / d : std::copysign(1e20f, d);
+}
+
+// Slab test of every lane against the box grown by `inflate`, bit i set if ray i enters it before its tmax
+static uint32_t packet_vs_aabb(const RayPacket& P, const AABB& box, float inflate) {
+#ifdef SQ_HAS_SSE2
+    __m128 tmin = _mm_setzero_ps();
+    __m128 tmax = _mm_load_ps(P.tmax);
+    for (uint32_t k = 0; k < 3; k++) {
+        __m128 o = _mm_load_ps(P.origin[k]);
+        __m128 inv = _mm_load_ps(P.inv_dir[k]);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min[k] - inflate), o), inv);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max[k] + inflate), o), inv);
+        tmin = _mm_max_ps(tmin, _mm_min_ps(t1, t2));
+        tmax = _mm_min_ps(tmax, _mm_max_ps(t1, t2));
+    }
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tmin, tmax)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t l = 0; l < SQ_PACKET_SIZE; l++) {
+        float tmin = 0.0f;
+        float tmax = P.tmax[l];
+        for (uint32_t k = 0; k < 3; k++) {
+            float t1 = (box.min[k] - inflate - P.origin[k][l]) * P.inv_dir[k][l];
+            float t2 = (box.max[k] + inflate - P.origin[k][l]) * P.inv_dir[k][l];
+            tmin = std::max(tmin, std::min(t1, t2));
+            tmax = std::min(tmax, std::max(t1, t2));
+        }
+        mask |= (tmin <= tmax ? 1u : 0u) << l;
+    }
+    return mask;
+#endif
+}
+
+void SceneQuery::clear() {
+    m_shapes.clear();
+    m_count = 0;
+    m_dirty = true;
+}
+
+template <typename T>
+void SceneQuery::set_shape(uint32_t slot, EntityID entity, const T& shape, const AABB& aabb, ColliderType type,
+                           LayerMask layer, bool is_trigger) {
+    if (slot >= m_shapes.size()) {
+        m_shapes.resize(slot + 1);
+    }
+
+    // A new shape changes the tree, a moved one only its bounds
+    Shape& s = m_shapes[slot];
+    if (s.entity == INVALID_ENTITY) {
+        m_count++;
+        m_dirty = true;
+    }
+    m_moved = true;
+
+    s.aabb = aabb;
+    s.shape = shape;
+    s.entity = entity;
+    s.layer = layer;
+    s.type = type;
+    s.is_trigger = is_trigger;
+}
+
+void SceneQuery::set(uint32_t slot, EntityID entity, const WorldSphere& sphere, LayerMask layer, bool is_trigger) {
+    set_shape(slot, entity, sphere, compute_world_aabb_from_sphere(sphere), ColliderType::Sphere, layer, is_trigger);
+}
+
+void SceneQuery::set(uint32_t slot, EntityID entity, const WorldOBB& obb, LayerMask layer, bool is_trigger) {
+    set_shape(slot, entity, obb, compute_world_aabb_from_obb(obb), ColliderType::OBB, layer, is_trigger);
+}
+
+void SceneQuery::set(uint32_t slot, EntityID entity, const WorldCapsule& capsule, LayerMask layer, bool is_trigger) {
+    set_shape(slot, entity, capsule, compute_world_aabb_from_capsule(capsule), ColliderType::Capsule, layer,
+              is_trigger);
+}
+
+void SceneQuery::set(uint32_t slot, EntityID entity, const WorldConvex& convex, LayerMask layer, bool is_trigger) {
+    set_shape(slot, entity, convex, compute_world_aabb_from_convex(convex), ColliderType::Convex, layer, is_trigger);
+}
+
+void SceneQuery::set(uint32_t slot, EntityID entity, const WorldMesh& mesh, LayerMask layer, bool is_trigger) {
+    set_shape(slot, entity, mesh, compute_world_aabb_from_mesh(mesh), ColliderType::Mesh, layer, is_trigger);
+}
+
+void SceneQuery::set_filter(uint32_t slot, LayerMask layer, bool is_trigger) {
+    if (slot >= m_shapes.size() || m_shapes[slot].entity == INVALID_ENTITY) {
+        throw std::runtime_error("[SceneQuery] Setting the filter of an empty slot!");
+    }
+
+    m_shapes[slot].layer = layer;
+    m_shapes[slot].is_trigger = is_trigger;
+}
+
+void SceneQuery::remove(uint32_t slot) {
+    if (slot >= m_shapes.size() || m_shapes[slot].entity == INVALID_ENTITY) {
+        throw std::runtime_error("[SceneQuery] Removing an empty slot!");
+    }
+
+    m_shapes[slot] = Shape{};
+    m_count--;
+    m_dirty = true;
+}
+
+uint32_t SceneQuery::raycast(const Ray& ray, QueryMode mode, std::vector<RayHit>& hits, const QueryFilter& filter) {
+    update();
+
+    uint32_t count = 0;
+    trace(&ray, 1, 0.0f, mode, filter, hits, &count, m_scratch);
+    return count;
+}
+
+uint32_t SceneQuery::sphere_cast(const Ray& ray, float radius, QueryMode mode, std::vector<RayHit>& hits,
+                                 const QueryFilter& filter) {
+    update();
+
+    uint32_t count = 0;
+    trace(&ray, 1, std::max(radius, 0.0f), mode, filter, hits, &count, m_scratch);
+    return count;
+}
+
+uint32_t SceneQuery::overlap_sphere(const WorldSphere& sphere, QueryMode mode, std::vector<EntityID>& entities,
+                                    const QueryFilter& filter) {
+    auto test = [&](const Shape& s) {
+        Contact c;
+        switch (s.type) {
+            case ColliderType::OBB: {
+                return sphere_vs_obb(0, sphere, 0, std::get<WorldOBB>(s.shape), c);
+            }
+            case ColliderType::Sphere: {
+                return sphere_vs_sphere(0, sphere, 0, std::get<WorldSphere>(s.shape), c);
+            }
+            case ColliderType::Capsule: {
+                return sphere_vs_capsule(0, sphere, 0, std::get<WorldCapsule>(s.shape), c);
+            }
+            case ColliderType::Convex: {
+                return convex_overlap(SupportShape(sphere), SupportShape(std::get<WorldConvex>(s.shape)));
+            }
+            case ColliderType::Mesh: {
+                return shape_overlaps_mesh(SupportShape(sphere), compute_world_aabb_from_sphere(sphere),
+                                           std::get<WorldMesh>(s.shape));
+            }
+            default: {
+                throw std::runtime_error("[SceneQuery] Unknown collider type!");
+            }
+        }
+    };
+    return overlap(compute_world_aabb_from_sphere(sphere), test, sphere.center, mode, entities, filter);
+}
+
+uint32_t SceneQuery::overlap_box(const WorldOBB& obb, QueryMode mode, std::vector<EntityID>& entities,
+                                 const QueryFilter& filter) {
+    auto test = [&](const Shape& s) {
+        Contact c;
+        switch (s.type) {
+            case ColliderType::OBB: {
+                return obb_vs_obb(0, obb, 0, std::get<WorldOBB>(s.shape), c);
+            }
+            case ColliderType::Sphere: {
+                return sphere_vs_obb(0, std::get<WorldSphere>(s.shape), 0, obb, c);
+            }
+            case ColliderType::Capsule: {
+                return capsule_vs_obb(0, std::get<WorldCapsule>(s.shape), 0, obb, c);
+            }
+            case ColliderType::Convex: {
+                return convex_overlap(SupportShape(obb), SupportShape(std::get<WorldConvex>(s.shape)));
+            }
+            case ColliderType::Mesh: {
+                return shape_overlaps_mesh(SupportShape(obb), compute_world_aabb_from_obb(obb),
+                                           std::get<WorldMesh>(s.shape));
+            }
+            default: {
+                throw std::runtime_error("[SceneQuery] Unknown collider type!");
+            }
+        }
+    };
+    return overlap(compute_world_aabb_from_obb(obb), test, obb.center, mode, entities, filter);
+}
+
+void SceneQuery::raycast_batch(std::span<const Ray> rays, QueryMode mode, RayBatchHits& out,
+                               const QueryFilter& filter) {
+    update();
+
+    uint32_t ray_count = static_cast<uint32_t>(rays.size());
+    uint32_t packets = (ray_count + SQ_PACKET_SIZE - 1) / SQ_PACKET_SIZE;
+    uint32_t chunks = parallel_chunks(packets, SQ_PARALLEL_GRAIN);
+    if (m_chunk_hits.size() < chunks) {
+        m_chunk_hits.resize(chunks);
+    }
+    m_counts.resize(ray_count);
+
+    // Every chunk owns a contiguous range of rays, so its hits are already in ray order
+    parallel_for(packets, SQ_PARALLEL_GRAIN, [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+        ChunkHits& ch = m_chunk_hits[chunk];
+        ch.hits.clear();
+
+        for (uint32_t p = begin; p < end; p++) {
+            uint32_t first = p * SQ_PACKET_SIZE;
+            uint32_t count = std::min<uint32_t>(SQ_PACKET_SIZE, ray_count - first);
+            trace(rays.data() + first, count, 0.0f, mode, filter, ch.hits, m_counts.data() + first, ch.scratch);
+        }
+    });
+
+    out.offsets.resize(ray_count + 1);
+    out.offsets[0] = 0;
+    for (uint32_t i = 0; i < ray_count; i++) {
+        out.offsets[i + 1] = out.offsets[i] + m_counts[i];
+    }
+
+    out.hits.clear();
+    for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+        out.hits.insert(out.hits.end(), m_chunk_hits[chunk].hits.begin(), m_chunk_hits[chunk].hits.end());
+    }
+}
+
+// Shapes added or removed since the last query change the tree, moved ones only its bounds
+void SceneQuery::update() {
+    if (m_dirty) {
+        build();
+    } else if (m_moved) {
+        refit();
+    }
+}
+
+// Top-down median split on the widest axis of the shape centers
+void SceneQuery::build() {
+    m_dirty = false;
+    m_moved = false;
+    m_nodes.clear();
+    m_order.clear();
+    for (uint32_t slot = 0; slot < m_shapes.size(); slot++) {
+        if (m_shapes[slot].entity != INVALID_ENTITY) {
+            m_order.push_back(slot);
+        }
+    }
+    if (m_order.empty()) {
+        return;
+    }
+
+    struct Task {
+        uint32_t node;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    // Of the box, not the shape
+    auto center = [&](uint32_t slot) { return (m_shapes[slot].aabb.min + m_shapes[slot].aabb.max) * 0.5f; };
+
+    std::vector<Task> tasks;
+    m_nodes.emplace_back();
+    tasks.push_back(Task{0, 0, static_cast<uint32_t>(m_order.size())});
+
+    while (!tasks.empty()) {
+        Task t = tasks.back();
+        tasks.pop_back();
+
+        AABB bounds = m_shapes[m_order[t.begin]].aabb;
+        AABB centers{center(m_order[t.begin]), center(m_order[t.begin])};
+        for (uint32_t i = t.begin + 1; i < t.end; i++) {
+            const AABB& aabb = m_shapes[m_order[i]].aabb;
+            bounds.min = glm::min(bounds.min, aabb.min);
+            bounds.max = glm::max(bounds.max, aabb.max);
+            centers.min = glm::min(centers.min, center(m_order[i]));
+            centers.max = glm::max(centers.max, center(m_order[i]));
+        }
+        m_nodes[t.node].aabb = bounds;
+
+        glm::vec3 spread = centers.max - centers.min;
+        uint32_t axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+
+        // Shapes sharing one center can't be split, they stay in a bigger leaf
+        if (t.end - t.begin <= SQ_LEAF_SIZE || spread[axis] <= 0.0f) {
+            m_nodes[t.node].first = t.begin;
+            m_nodes[t.node].count = t.end - t.begin;
+            continue;
+        }
+
+        uint32_t mid = (t.begin + t.end) / 2;
+        std::nth_element(m_order.begin() + t.begin, m_order.begin() + mid, m_order.begin() + t.end,
+                         [&](uint32_t a, uint32_t b) { return center(a)[axis] < center(b)[axis]; });
+
+        uint32_t left = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+        m_nodes.emplace_back();
+        m_nodes[t.node].first = left;
+        m_nodes[t.node].axis = axis;
+
+        tasks.push_back(Task{left, t.begin, mid});
+        tasks.push_back(Task{left + 1, mid, t.end});
+    }
+}
+
+// Children always come after their parent, so walking the nodes backwards visits
+// both children before it
+void SceneQuery::refit() {
+    m_moved = false;
+    for (uint32_t k = static_cast<uint32_t>(m_nodes.size()); k-- > 0;) {
+        Node& n = m_nodes[k];
+        if (n.count == 0) {
+            const AABB& left = m_nodes[n.first].aabb;
+            const AABB& right = m_nodes[n.first + 1].aabb;
+            n.aabb = AABB{glm::min(left.min, right.min), glm::max(left.max, right.max)};
+            continue;
+        }
+
+        n.aabb = m_shapes[m_order[n.first]].aabb;
+        for (uint32_t i = n.first + 1; i < n.first + n.count; i++) {
+            n.aabb.min = glm::min(n.aabb.min, m_shapes[m_order[i]].aabb.min);
+            n.aabb.max = glm::max(n.aabb.max, m_shapes[m_order[i]].aabb.max);
+        }
+    }
+}
+
+bool SceneQuery::accepts(const Shape& s, const QueryFilter& filter) const {
+    return (s.layer & filter.layers) && (!s.is_trigger || filter.include_triggers) && s.entity != filter.ignore;
+}
+
+glm::vec3 SceneQuery::shape_center(const Shape& s) {
+    switch (s.type) {
+        case ColliderType::OBB: {
+            return std::get<WorldOBB>(s.shape).center;
+        }
+        case ColliderType::Sphere: {
+            return std::get<WorldSphere>(s.shape).center;
+        }
+        case ColliderType::Capsule: {
+            const WorldCapsule& capsule = std::get<WorldCapsule>(s.shape);
+            return (capsule.p0 + capsule.p1) * 0.5f;
+        }
+        case ColliderType::Convex: {
+            const WorldConvex& convex = std::get<WorldConvex>(s.shape);
+            return convex.basis * convex.hull->centroid() + convex.origin;
+        }
+        case ColliderType::Mesh: {
+            return (s.aabb.min + s.aabb.max) * 0.5f;
+        }
+        default: {
+            throw std::runtime_error("[SceneQuery] Unknown collider type!");
+        }
+    }
+}
+
+bool SceneQuery::cast(const Shape& s, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit) {
+    switch (s.type) {
+        case ColliderType::OBB: {
+            return cast_obb(std::get<WorldOBB>(s.shape), o, d, radius, tmax, hit);
+        }
+        case ColliderType::Sphere: {
+            return cast_sphere(std::get<WorldSphere>(s.shape), o, d, radius, tmax, hit);
+        }
+        case ColliderType::Capsule: {
+            return cast_capsule(std::get<WorldCapsule>(s.shape), o, d, radius, tmax, hit);
+        }
+        case ColliderType::Convex: {
+            return cast_convex(std::get<WorldConvex>(s.shape), o, d, radius, tmax, hit);
+        }
+        case ColliderType::Mesh: {
+            return cast_mesh(std::get<WorldMesh>(s.shape), o, d, radius, tmax, hit);
+        }
+        default: {
+            throw std::runtime_error("[SceneQuery] Unknown collider type!");
+        }
+    }
+}
+
+void SceneQuery::trace(const Ray* rays, uint32_t count, float radius, QueryMode mode, const QueryFilter& filter,
+                       std::vector<RayHit>& out, uint32_t* counts, std::vector<LaneHit>& scratch) const {
+    RayPacket P;
+    glm::vec3 dirs[SQ_PACKET_SIZE];
+    glm::vec3 origins[SQ_PACKET_SIZE];
+    RayHit best[SQ_PACKET_SIZE];
+    bool found[SQ_PACKET_SIZE] = {};
+
+    for (uint32_t l = 0; l < SQ_PACKET_SIZE; l++) {
+        bool active = l < count && glm::dot(rays[l].direction, rays[l].direction) > 0.0f;
+        origins[l] = active ? rays[l].origin : glm::vec3(0.0f);
+        dirs[l] = active ? glm::normalize(rays[l].direction) : glm::vec3(1.0f, 0.0f, 0.0f);
+
+        for (uint32_t k = 0; k < 3; k++) {
+            P.origin[k][l] = origins[l][k];
+            P.inv_dir[k][l] = safe_inverse(dirs[l][k]);
+        }
+        P.tmax[l] = active ? rays[l].max_distance : -1.0f;
+    }
+    scratch.clear();
+
+    uint32_t stack[SQ_STACK_SIZE];
+    uint32_t size = 0;
+    if (!m_nodes.empty()) {
+        stack[size++] = 0;
+    }
+
+    while (size > 0) {
+        const Node& n = m_nodes[stack[--size]];
+        uint32_t mask = packet_vs_aabb(P, n.aabb, radius);
+        if (!mask) {
+            continue;
+        }
+
+        if (n.count == 0) {
+            // Nearer child on top, judged by the first ray still in
+            bool negative = dirs[std::countr_zero(mask)][n.axis] < 0.0f;
+            stack[size++] = negative ? n.first : n.first + 1;
+            stack[size++] = negative ? n.first + 1 : n.first;
+            continue;
+        }
+
+        for (uint32_t i = n.first; i < n.first + n.count; i++) {
+            const Shape& s = m_shapes[m_order[i]];
+            if (!accepts(s, filter)) {
+                continue;
+            }
+
+            for (uint32_t bits = mask; bits; bits &= bits - 1) {
+                uint32_t l = std::countr_zero(bits);
+                if (P.tmax[l] < 0.0f) {
+                    continue;
+                }
+
+                RayHit hit;
+                if (!cast(s, origins[l], dirs[l], radius, P.tmax[l], hit)) {
+                    continue;
+                }
+                hit.entity = s.entity;
+
+                switch (mode) {
+                    case QueryMode::Closest: {
+                        best[l] = hit;
+                        found[l] = true;
+                        P.tmax[l] = hit.distance;  // only nearer hits from now on
+                        break;
+                    }
+                    case QueryMode::Any: {
+                        best[l] = hit;
+                        found[l] = true;
+                        P.tmax[l] = -1.0f;  // done
+                        break;
+                    }
+                    case QueryMode::All: {
+                        scratch.push_back(LaneHit{l, hit});
+                        break;
+                    }
+                    default: {
+                        throw std::runtime_error("[SceneQuery] Unknown query mode!");
+                    }
+                }
+            }
+        }
+    }
+
+    if (mode == QueryMode::All) {
+        std::stable_sort(scratch.begin(), scratch.end(), [](const LaneHit& a, const LaneHit& b) {
+            return a.lane < b.lane || (a.lane == b.lane && a.hit.distance < b.hit.distance);
+        });
+    }
+
+    uint32_t next = 0;
+    for (uint32_t l = 0; l < count; l++) {
+        counts[l] = 0;
+        if (mode != QueryMode::All) {
+            if (found[l]) {
+                out.push_back(best[l]);
+                counts[l] = 1;
+            }
+            continue;
+        }
+
+        for (; next < scratch.size() && scratch[next].lane == l; next++) {
+            out.push_back(scratch[next].hit);
+            counts[l]++;
+        }
+    }
+}
+
+template <typename F>
+uint32_t SceneQuery::overlap(const AABB& aabb, F&& test, const glm::vec3& center, QueryMode mode,
+                             std::vector<EntityID>& entities, const QueryFilter& filter) {
+    update();
+
+    uint32_t found = 0;
+    EntityID closest = INVALID_ENTITY;
+    float closest_dist2 = FLT_MAX;
+
+    uint32_t stack[SQ_STACK_SIZE];
+    uint32_t size = 0;
+    if (!m_nodes.empty()) {
+        stack[size++] = 0;
+    }
+
+    while (size > 0) {
+        const Node& n = m_nodes[stack[--size]];
+        if (!aabb_overlap(n.aabb, aabb)) {
+            continue;
+        }
+
+        if (n.count == 0) {
+            stack[size++] = n.first;
+            stack[size++] = n.first + 1;
+            continue;
+        }
+
+        for (uint32_t i = n.first; i < n.first + n.count; i++) {
+            const Shape& s = m_shapes[m_order[i]];
+            if (!accepts(s, filter) || !aabb_overlap(s.aabb, aabb) || !test(s)) {
+                continue;
+            }
+
+            if (mode == QueryMode::Closest) {
+                // Nearest by center, e.g. the nearest target in range
+                glm::vec3 d = shape_center(s) - center;
+                if (glm::dot(d, d) < closest_dist2) {
+                    closest_dist2 = glm::dot(d, d);
+                    closest = s.entity;
+                }
+                continue;
+            }
+
+            entities.push_back(s.entity);
+            found++;
+            if (mode == QueryMode::Any) {
+                return found;
+            }
+        }
+    }
+
+    if (closest != INVALID_ENTITY) {
+        entities.push_back(closest);
+        found++;
+    }
+    return found;
+}
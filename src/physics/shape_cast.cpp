@@ -0,0 +1,320 @@
+#include "physics/shape_cast.h"
+#include "physics/narrowphase.h"
+
+#include <algorithm>
+#include <cmath>
+
+static bool ray_vs_sphere(const glm::vec3& o, const glm::vec3& d, const glm::vec3& center, float radius, float tmax,
+                          float& t) {
+    glm::vec3 m = o - center;
+    float b = glm::dot(m, d);
+    float c = glm::dot(m, m) - radius * radius;
+    if (c <= 0.0f) {
+        t = 0.0f;
+        return true;
+    }
+
+    // Outside and pointing away
+    if (b > 0.0f) {
+        return false;
+    }
+
+    float disc = b * b - c;
+    if (disc < 0.0f) {
+        return false;
+    }
+
+    t = std::max(-b - std::sqrt(disc), 0.0f);
+    return t <= tmax;
+}
+
+// Slab test against a world box, false when the ray misses it within tmax
+static bool ray_vs_aabb(const glm::vec3& o, const glm::vec3& d, const AABB& aabb, float tmax, float& t_enter,
+                        float& t_exit) {
+    t_enter = 0.0f;
+    t_exit = tmax;
+    for (uint32_t k = 0; k < 3; k++) {
+        if (std::abs(d[k]) < COL_EPS) {
+            if (o[k] < aabb.min[k] || o[k] > aabb.max[k]) {
+                return false;
+            }
+            continue;
+        }
+
+        float inv = 1.0f / d[k];
+        float t1 = (aabb.min[k] - o[k]) * inv;
+        float t2 = (aabb.max[k] - o[k]) * inv;
+        t_enter = std::max(t_enter, std::min(t1, t2));
+        t_exit = std::min(t_exit, std::max(t1, t2));
+        if (t_enter > t_exit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Slab test in the box's frame against `half_extents`. The entry normal is the face's
+// outward axis, zero when the ray starts inside
+static bool ray_vs_obb(const glm::vec3& o, const glm::vec3& d, const WorldOBB& obb, const glm::vec3& half_extents,
+                       float tmax, float& t_enter, float& t_exit, glm::vec3& normal) {
+    glm::vec3 rel = o - obb.center;
+    t_enter = 0.0f;
+    t_exit = tmax;
+    normal = glm::vec3(0.0f);
+
+    for (uint32_t k = 0; k < 3; k++) {
+        float o_local = glm::dot(rel, obb.axes[k]);
+        float d_local = glm::dot(d, obb.axes[k]);
+        float h = half_extents[k];
+
+        if (std::abs(d_local) < COL_EPS) {
+            if (std::abs(o_local) > h) {
+                return false;
+            }
+            continue;
+        }
+
+        float inv = 1.0f / d_local;
+        float t1 = (-h - o_local) * inv;
+        float t2 = (h - o_local) * inv;
+        if (t1 > t2) {
+            std::swap(t1, t2);
+        }
+
+        if (t1 > t_enter) {
+            t_enter = t1;
+            normal = d_local > 0.0f ? -obb.axes[k] : obb.axes[k];
+        }
+        t_exit = std::min(t_exit, t2);
+        if (t_enter > t_exit) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool cast_sphere(const WorldSphere& s, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit) {
+    float t;
+    if (!ray_vs_sphere(o, d, s.center, s.radius + radius, tmax, t)) {
+        return false;
+    }
+
+    hit.distance = t;
+    if (t > 0.0f) {
+        hit.normal = glm::normalize(o + d * t - s.center);
+        hit.point = s.center + hit.normal * s.radius;
+    } else {
+        hit.normal = -d;
+        hit.point = o;
+    }
+    return true;
+}
+
+bool cast_obb(const WorldOBB& obb, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit) {
+    float t_enter, t_exit;
+    glm::vec3 normal;
+    if (!ray_vs_obb(o, d, obb, obb.half_extents + glm::vec3(radius), tmax, t_enter, t_exit, normal)) {
+        return false;
+    }
+
+    if (radius <= 0.0f) {
+        hit.distance = t_enter;
+        hit.point = o + d * t_enter;
+        hit.normal = t_enter > 0.0f ? normal : -d;
+        return true;
+    }
+
+    // The grown box has sharp corners where the swept sphere has round ones: advance from
+    // its entry to the plane through the closest point of the real box, which lies
+    // entirely behind it, until the sphere touches it
+    float t = t_enter;
+    for (uint32_t i = 0; i < CAST_MAX_ITERATIONS; i++) {
+        glm::vec3 p = o + d * t;
+        glm::vec3 q = closest_point_on_obb(obb, p);
+        float dist = glm::length(p - q);
+
+        if (dist <= radius + CAST_TOLERANCE) {
+            hit.distance = t;
+            hit.point = q;
+            hit.normal = dist > COL_EPS ? (p - q) / dist : -d;
+            return true;
+        }
+
+        float approach = glm::dot(d, q - p) / dist;
+        if (approach <= 0.0f) {
+            return false;
+        }
+
+        t += (dist - radius) / approach;
+        if (t > t_exit) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool cast_capsule(const WorldCapsule& cap, const glm::vec3& o, const glm::vec3& d, float radius, float tmax,
+                  RayHit& hit) {
+    float r = cap.radius + radius;
+    glm::vec3 core = closest_point_on_segment(cap.p0, cap.p1, o);
+    if (glm::dot(o - core, o - core) <= r * r) {
+        hit.distance = 0.0f;
+        hit.normal = -d;
+        hit.point = o;
+        return true;
+    }
+
+    // First entry into the union of the two end spheres and the cylinder between
+    // them, whose flat ends are inside the spheres
+    bool found = false;
+    float t = tmax;
+    float t_cap;
+    if (ray_vs_sphere(o, d, cap.p0, r, tmax, t_cap)) {
+        found = true;
+        t = t_cap;
+    }
+    if (ray_vs_sphere(o, d, cap.p1, r, tmax, t_cap)) {
+        found = true;
+        t = std::min(t, t_cap);
+    }
+
+    glm::vec3 axis = cap.p1 - cap.p0;
+    glm::vec3 oa = o - cap.p0;
+    float axis2 = glm::dot(axis, axis);
+    float axis_d = glm::dot(axis, d);
+    float axis_oa = glm::dot(axis, oa);
+    float a = axis2 - axis_d * axis_d;
+    if (a > COL_EPS * axis2) {
+        float b = axis2 * glm::dot(d, oa) - axis_oa * axis_d;
+        float c = axis2 * glm::dot(oa, oa) - axis_oa * axis_oa - r * r * axis2;
+        float h = b * b - a * c;
+        if (h >= 0.0f) {
+            float t_body = (-b - std::sqrt(h)) / a;
+            float y = axis_oa + t_body * axis_d;
+            if (t_body >= 0.0f && t_body <= tmax && y >= 0.0f && y <= axis2) {
+                found = true;
+                t = std::min(t, t_body);
+            }
+        }
+    }
+
+    // A miss is no hit at tmax, which is FLT_MAX for unbounded rays
+    if (!found) {
+        return false;
+    }
+
+    glm::vec3 p = o + d * t;
+    core = closest_point_on_segment(cap.p0, cap.p1, p);
+    hit.distance = t;
+    hit.normal = glm::normalize(p - core);
+    hit.point = core + hit.normal * cap.radius;
+    return true;
+}
+
+// Conservative advancement against a convex core: each step goes to where the sphere
+// reaches the plane through the closest point, which the shape lies entirely behind
+static bool advance_to_convex(const SupportShape& shape, const glm::vec3& o, const glm::vec3& d, float radius,
+                              float t, float t_exit, RayHit& hit) {
+    SupportShape point;
+    GjkCache cache;
+    glm::vec3 normal = -d;
+    for (uint32_t i = 0; i < CAST_MAX_ITERATIONS; i++) {
+        point.points[0] = o + d * t;
+
+        GjkSimplex simplex;
+        float dist;
+        glm::vec3 pa, pb;
+        if (!gjk_distance(point, shape, simplex, dist, pa, pb, &cache)) {
+            // Inside at the start, or a ray that reached the surface exactly
+            hit.distance = t;
+            hit.point = point.points[0];
+            hit.normal = normal;
+            return true;
+        }
+
+        // Too close the direction is noise, the plane stepped to is kept instead
+        if (dist > CAST_TOLERANCE) {
+            normal = (pa - pb) / dist;
+        }
+        if (dist <= radius + CAST_TOLERANCE) {
+            hit.distance = t;
+            hit.point = pb;
+            hit.normal = normal;
+            return true;
+        }
+
+        float approach = -glm::dot(d, normal);
+        if (approach <= 0.0f) {
+            return false;
+        }
+
+        t += (dist - radius) / approach;
+        if (t > t_exit) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool cast_convex(const WorldConvex& c, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit) {
+    AABB bounds = compute_world_aabb_from_convex(c);
+    bounds.min -= glm::vec3(radius);
+    bounds.max += glm::vec3(radius);
+
+    float t_enter, t_exit;
+    if (!ray_vs_aabb(o, d, bounds, tmax, t_enter, t_exit)) {
+        return false;
+    }
+    return advance_to_convex(SupportShape(c), o, d, radius, t_enter, t_exit, hit);
+}
+
+bool cast_mesh(const WorldMesh& m, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit) {
+    glm::vec3 a, b, c;
+    if (radius <= 0.0f) {
+        // The model matrix is affine, so t is the same along the local ray
+        glm::vec3 local_o(m.inverse * glm::vec4(o, 1.0f));
+        glm::vec3 local_d = glm::mat3(m.inverse) * d;
+        float t;
+        uint32_t tri;
+        if (!m.mesh->raycast(local_o, local_d, tmax, t, tri)) {
+            return false;
+        }
+
+        m.triangle(tri, a, b, c);
+        glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+        hit.distance = t;
+        hit.point = o + d * t;
+        hit.normal = glm::dot(normal, d) > 0.0f ? -normal : normal;
+        return true;
+    }
+
+    AABB bounds = compute_world_aabb_from_mesh(m);
+    bounds.min -= glm::vec3(radius);
+    bounds.max += glm::vec3(radius);
+
+    float t_enter, t_exit;
+    if (!ray_vs_aabb(o, d, bounds, tmax, t_enter, t_exit)) {
+        return false;
+    }
+
+    // Only the triangles near the swept sphere, each advanced against on its own
+    glm::vec3 start = o + d * t_enter;
+    glm::vec3 end = o + d * t_exit;
+    AABB swept{glm::min(start, end) - glm::vec3(radius), glm::max(start, end) + glm::vec3(radius)};
+    AABB local = transform_aabb(swept, glm::mat3(m.inverse), glm::vec3(m.inverse[3]));
+
+    bool found = false;
+    m.mesh->query(local, [&](uint32_t t) {
+        m.triangle(t, a, b, c);
+        RayHit tri_hit;
+        if (advance_to_convex(SupportShape::triangle(a, b, c), o, d, radius, t_enter, t_exit, tri_hit)) {
+            hit = tri_hit;
+            t_exit = tri_hit.distance;
+            found = true;
+        }
+    });
+    return found;
+}
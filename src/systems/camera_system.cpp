@@ -30,8 +30,12 @@ void transform_aabb(const glm::vec3& in_min, const glm::vec3& in_max, const glm:
     }
 }
 
+void CameraSystem::init(Engine& engine) {
+    m_cc = engine.cm().ref<const CameraContext>();
+}
+
 void CameraSystem::update(Engine& engine) {
-    auto& cc = engine.cm().get<CameraContext>();
+    auto& cc = *m_cc;
 
     EntityManager& em = engine.em();
 
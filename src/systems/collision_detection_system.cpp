@@ -1,12 +1,18 @@
 #include "systems/collision_detection_system.h"
 #include "components/transform.h"
 #include "components/collider.h"
+#include "components/rigidbody.h"
 #include "components/model.h"
 #include "core/types/aabb.h"
 #include "assets/model_asset.h"
 #include "assets/mesh_asset.h"
 #include "contexts/collision_context.h"
+#include "physics/broadphase.h"
+#include "physics/narrowphase.h"
+#include "physics/shape_cast.h"
+#include "physics/shapes.h"
 #include "core/engine.h"
+#include "core/thread_pool.h"
 #include "managers/context_manager.h"
 #include "managers/entity_manager.h"
 #include "managers/asset_manager.h"
@@ -15,308 +21,307 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <stdexcept>
 
-#define COL_EPS 1e-6f
-
-struct WorldOBB {
-    glm::vec3 center;
-    glm::vec3 half_extents;  // half extents in world units
-    glm::vec3 axes[3];       // unit axes in world space
-
-    WorldOBB() = default;
-
-    WorldOBB(Transform& tr, Collider& c) {
-        const glm::mat4& M = tr.model_matrix();
-        glm::vec3 x(M[0]);
-        glm::vec3 y(M[1]);
-        glm::vec3 z(M[2]);
-
-        glm::vec4 local_center(c.offset, 1.0f);
-        center = glm::vec3(M * local_center);
-
-        glm::vec3 half_extents_local = c.size * 0.5f;
-        half_extents.x = glm::length(x) * half_extents_local.x;
-        half_extents.y = glm::length(y) * half_extents_local.y;
-        half_extents.z = glm::length(z) * half_extents_local.z;
-
-        axes[0] = glm::normalize(x);
-        axes[1] = glm::normalize(y);
-        axes[2] = glm::normalize(z);
-    }
-};
-
-struct WorldSphere {
-    glm::vec3 center;
-    float radius;
-
-    WorldSphere() = default;
-
-    WorldSphere(Transform& tr, Collider& c) {
-        const glm::mat4& M = tr.model_matrix();
-
-        glm::vec4 local_center(c.offset, 1.0f);
-        center = (M * local_center);
-
-        float sx = glm::length(glm::vec3(M[0]));
-        float sy = glm::length(glm::vec3(M[1]));
-        float sz = glm::length(glm::vec3(M[2]));
-        float max_scale = glm::max(sx, glm::max(sy, sz));
-
-        radius = c.size.x * max_scale;
-    }
-};
-struct WorldCapsule {
-    glm::vec3 p0;  // bottom center point
-    glm::vec3 p1;  // top center point
-    float radius;  // radius of the capsule
-
-    WorldCapsule() = default;
-
-    WorldCapsule(Transform& tr, Collider& c) {
-        const glm::mat4& M = tr.model_matrix();
-
-        glm::vec4 local_center(c.offset, 1.0f);
-        glm::vec3 center(M * local_center);
-
-        glm::vec3 up = glm::normalize(glm::vec3(M[1]));  // Y axis in world space
-        float sx = glm::length(glm::vec3(M[0]));
-        float sy = glm::length(glm::vec3(M[1]));
-
-        float hh = (c.size.y * 0.5f) * sy;  // half height
-
-        p0 = center - up * hh;
-        p1 = center + up * hh;
-        radius = c.size.x * sx;
-    }
-};
-
-AABB compute_world_aabb_from_sphere(const WorldSphere& s) {
-    glm::vec3 radius_vec(s.radius);
-    return AABB{.min = s.center - radius_vec, .max = s.center + radius_vec};
-}
-
-AABB compute_world_aabb_from_obb(const WorldOBB& obb) {
-    glm::vec3 e0 = glm::abs(obb.axes[0]) * obb.half_extents.x;
-    glm::vec3 e1 = glm::abs(obb.axes[1]) * obb.half_extents.y;
-    glm::vec3 e2 = glm::abs(obb.axes[2]) * obb.half_extents.z;
-
-    glm::vec3 extents = e0 + e1 + e2;
-
-    return AABB{.min = obb.center - extents, .max = obb.center + extents};
-}
+#define NARROWPHASE_PARALLEL_GRAIN 128
 
 struct CollisionEntry {
-    CollisionEntry(EntityID _id, Transform* transform_ptr, Collider* collider_ptr) {
+    // Recomputes the world shape only when the transform or the collider's shape changed
+    // since the last call, returns whether it did
+    bool refresh(EntityID _id, Transform* transform_ptr, Collider* collider_ptr) {
         if (!transform_ptr || !collider_ptr) {
-            throw std::runtime_error("[CollisionEntry] Providing null pointers to the constructor!");
+            throw std::runtime_error("[CollisionEntry] Providing null pointers to refresh()!");
         }
 
-        id = _id;
+        // A different pointer may be a new entity that reuses the id
+        bool changed = id != _id || tr != transform_ptr || col != collider_ptr ||
+                       tr_version != transform_ptr->version() || type != collider_ptr->type ||
+                       size != collider_ptr->size || offset != collider_ptr->offset ||
+                       (type == ColliderType::Convex && convex.hull != collider_ptr->hull.get()) ||
+                       (type == ColliderType::Mesh && mesh.mesh != collider_ptr->mesh.get());
 
+        id = _id;
         tr = transform_ptr;
         col = collider_ptr;
+        if (!changed) {
+            return false;
+        }
 
-        is_sphere = col->type == ColliderType::Sphere;
+        tr_version = tr->version();
+        type = col->type;
+        size = col->size;
+        offset = col->offset;
 
-        if (is_sphere) {
-            sphere = WorldSphere(*tr, *col);
-            collider_aabb = compute_world_aabb_from_sphere(sphere);
-        } else {
-            obb = WorldOBB(*tr, *col);
-            collider_aabb = compute_world_aabb_from_obb(obb);
+        switch (type) {
+            case ColliderType::OBB: {
+                obb = WorldOBB(*tr, *col);
+                collider_aabb = compute_world_aabb_from_obb(obb);
+                break;
+            }
+            case ColliderType::Sphere: {
+                sphere = WorldSphere(*tr, *col);
+                collider_aabb = compute_world_aabb_from_sphere(sphere);
+                break;
+            }
+            case ColliderType::Capsule: {
+                capsule = WorldCapsule(*tr, *col);
+                collider_aabb = compute_world_aabb_from_capsule(capsule);
+                break;
+            }
+            case ColliderType::Convex: {
+                convex = WorldConvex(*tr, *col);
+                collider_aabb = compute_world_aabb_from_convex(convex);
+                break;
+            }
+            case ColliderType::Mesh: {
+                mesh = WorldMesh(*tr, *col);
+                collider_aabb = compute_world_aabb_from_mesh(mesh);
+                break;
+            }
+            default: {
+                throw std::runtime_error("[CollisionEntry] Unknown collider type!");
+            }
         }
+        return true;
     }
 
-    EntityID id;
+    EntityID id = INVALID_ENTITY;
 
     Transform* tr = nullptr;
     Collider* col = nullptr;
 
-    bool is_sphere;
+    ColliderType type = ColliderType::OBB;
+
+    // What the world shape was computed from
+    uint32_t tr_version = 0;
+    glm::vec3 size{0.0f};
+    glm::vec3 offset{0.0f};
 
     WorldSphere sphere;
     WorldOBB obb;
+    WorldCapsule capsule;
+    WorldConvex convex;
+    WorldMesh mesh;
 
     AABB collider_aabb;
-};
 
-bool aabb_overlap(const AABB& A, const AABB& B) {
-    return (A.min.x <= B.max.x && A.max.x >= B.min.x) && (A.min.y <= B.max.y && A.max.y >= B.min.y) &&
-           (A.min.z <= B.max.z && A.max.z >= B.min.z);
-}
-
-bool sphere_vs_sphere(EntityID a, const WorldSphere& A, EntityID b, const WorldSphere& B, Contact& out) {
-    glm::vec3 d = B.center - A.center;
-    float dist2 = dot(d, d);
-    float rsum = A.radius + B.radius;
-    if (dist2 >= rsum * rsum) {
-        return false;
+    glm::vec3 displacement{0.0f};  // integrated this step, zero for bodies that don't move
+    bool ccd = false;              // swept this step
+    bool frozen = false;   // asleep or skipped by its level of detail, it doesn't move this step
+    bool changed = false;  // shape or proxy changed this step, its pairs can't keep last step's contacts
+
+    // Largest sphere inside the shape, what swept bodies are cast as
+    void inner_sphere(glm::vec3& center, float& radius) const {
+        switch (type) {
+            case ColliderType::OBB: {
+                center = obb.center;
+                radius = glm::min(obb.half_extents.x, glm::min(obb.half_extents.y, obb.half_extents.z));
+                break;
+            }
+            case ColliderType::Sphere: {
+                center = sphere.center;
+                radius = sphere.radius;
+                break;
+            }
+            case ColliderType::Capsule: {
+                center = (capsule.p0 + capsule.p1) * 0.5f;
+                radius = capsule.radius;
+                break;
+            }
+            case ColliderType::Convex: {
+                center = convex.basis * convex.hull->centroid() + convex.origin;
+                float scale = glm::min(glm::length(convex.basis[0]),
+                                       glm::min(glm::length(convex.basis[1]), glm::length(convex.basis[2])));
+                radius = convex.hull->inner_radius() * scale;
+                break;
+            }
+            case ColliderType::Mesh: {
+                // No inside to speak of, cast as a ray
+                center = (collider_aabb.min + collider_aabb.max) * 0.5f;
+                radius = 0.0f;
+                break;
+            }
+            default: {
+                throw std::runtime_error("[CollisionEntry] Unknown collider type!");
+            }
+        }
     }
-    // Use sqrt over dist2 since glm::lenght does the same
-    float dist = sqrt(std::max(dist2, COL_EPS));
 
-    out.a = a;
-    out.b = b;
-    out.normal = (dist > COL_EPS) ? (d / dist) : glm::vec3(1, 0, 0);
-    out.penetration = rsum - dist;
-    out.position = A.center + out.normal * (A.radius - out.penetration * 0.5f);
-    out.is_trigger = false;
-    return true;
-}
-
-bool sphere_vs_obb(EntityID a, const WorldSphere& s, EntityID b, const WorldOBB& obb, Contact& out) {
-    // Find closest point on WorldOBB to sphere center
-    // Transform sphere center into WorldOBB local space: local = rot_mat^t * (point - center)
-    glm::mat3 rot_mat(obb.axes[0], obb.axes[1], obb.axes[2]);
-    glm::vec3 local = transpose(rot_mat) * (s.center - obb.center);
-    glm::vec3 clamped = clamp(local, -obb.half_extents, obb.half_extents);
-    glm::vec3 closest = rot_mat * clamped + obb.center;
-    glm::vec3 d = s.center - closest;
-    float dist2 = dot(d, d);
-    if (dist2 > s.radius * s.radius) {
-        return false;
+    // Swept bodies cover their whole motion so the broadphase pairs them with what they cross
+    AABB proxy_aabb() const {
+        if (!ccd) {
+            return collider_aabb;
+        }
+        return AABB{glm::min(collider_aabb.min, collider_aabb.min - displacement),
+                    glm::max(collider_aabb.max, collider_aabb.max - displacement)};
     }
 
-    float dist = sqrt(std::max(dist2, COL_EPS));
-
-    out.a = a;
-    out.b = b;
-    out.normal = (dist > COL_EPS) ? (d / dist) : glm::vec3(1, 0, 0);
-    out.penetration = s.radius - dist;
-    out.position = closest;
-    out.is_trigger = false;
-    return true;
-}
-
-bool obb_vs_obb(EntityID a, const WorldOBB& A, EntityID b, const WorldOBB& B, Contact& out) {
-    // Compute rotation matrix expressing B in A's local frame: rot_mat = rot_mat_A^t * rot_mat_B
-    glm::mat3 rot_mat_A(A.axes[0], A.axes[1], A.axes[2]);
-    glm::mat3 rot_mat_B(B.axes[0], B.axes[1], B.axes[2]);
-
-    glm::mat3 rot_mat = glm::transpose(rot_mat_A) * rot_mat_B;
-
-    // Translation from A to B in world space, then express in A's frame
-    glm::vec3 t_world = B.center - A.center;
-    glm::vec3 t = transpose(rot_mat_A) * t_world;  // t in A's local coords
-
-    // Compute common subexpressions abs(rot_mat) + COL_EPS
-    glm::mat3 abs_R;
-    for (int32_t i = 0; i < 3; ++i) {
-        for (int32_t j = 0; j < 3; ++j) {
-            abs_R[i][j] = std::abs(rot_mat[i][j]) + COL_EPS;
+    bool cast(const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit) const {
+        switch (type) {
+            case ColliderType::OBB: {
+                return cast_obb(obb, o, d, radius, tmax, hit);
+            }
+            case ColliderType::Sphere: {
+                return cast_sphere(sphere, o, d, radius, tmax, hit);
+            }
+            case ColliderType::Capsule: {
+                return cast_capsule(capsule, o, d, radius, tmax, hit);
+            }
+            case ColliderType::Convex: {
+                return cast_convex(convex, o, d, radius, tmax, hit);
+            }
+            case ColliderType::Mesh: {
+                return cast_mesh(mesh, o, d, radius, tmax, hit);
+            }
+            default: {
+                throw std::runtime_error("[CollisionEntry] Unknown collider type!");
+            }
         }
     }
 
-    // half extents
-    glm::vec3 a_he = A.half_extents;
-    glm::vec3 b_he = B.half_extents;
-
-    // Test the 15 axes and find the minimal penetration axis
-    float min_overlap = FLT_MAX;
-    glm::vec3 min_axis(1, 0, 0);
-    bool separated = false;
-
-    auto text_axis_fn = [&](const glm::vec3& axis_world, float proj_a, float proj_b, float dist_along_axis) -> bool {
-        float overlap = proj_a + proj_b - std::abs(dist_along_axis);
-        if (overlap < 0.0f) {
-            separated = true;
-            return false;
+    // The shape as GJK sees it, pointing into this entry
+    SupportShape support_shape() const {
+        switch (type) {
+            case ColliderType::OBB: {
+                return SupportShape(obb);
+            }
+            case ColliderType::Sphere: {
+                return SupportShape(sphere);
+            }
+            case ColliderType::Capsule: {
+                return SupportShape(capsule);
+            }
+            case ColliderType::Convex: {
+                return SupportShape(convex);
+            }
+            default: {
+                throw std::runtime_error("[CollisionEntry] Meshes have no support function!");
+            }
         }
+    }
+};
 
-        if (overlap < min_overlap) {
-            min_overlap = overlap;
-            min_axis = axis_world;
+// The scene queries keep each collider's world shape in the slot of its entry
+static void set_query_shape(SceneQuery& queries, uint32_t slot, const CollisionEntry& entry) {
+    const Collider& col = *entry.col;
+    switch (entry.type) {
+        case ColliderType::OBB: {
+            queries.set(slot, entry.id, entry.obb, col.layer, col.is_trigger);
+            break;
         }
-
-        return true;
-    };
-
-    // Test axes L0, L1, L2 (A's local axes)
-    // For A frame i: proj_a = a_he[i]
-    // For B frame onto A axis: proj_b = sum_j (b_he[j] * abs_R[i][j])
-    for (int32_t i = 0; i < 3 && !separated; ++i) {
-        float proj_a = a_he[i];
-        float proj_b = b_he[0] * abs_R[i][0] + b_he[1] * abs_R[i][1] + b_he[2] * abs_R[i][2];
-        float dist = t[i];  // projection of t onto A's axis i (since t is in A frame)
-        glm::vec3 axis_world = rot_mat_A * glm::vec3((i == 0), (i == 1), (i == 2));  // i-th world axis of A
-        if (!text_axis_fn(axis_world, proj_a, proj_b, dist)) {
-            return false;
+        case ColliderType::Sphere: {
+            queries.set(slot, entry.id, entry.sphere, col.layer, col.is_trigger);
+            break;
+        }
+        case ColliderType::Capsule: {
+            queries.set(slot, entry.id, entry.capsule, col.layer, col.is_trigger);
+            break;
+        }
+        case ColliderType::Convex: {
+            queries.set(slot, entry.id, entry.convex, col.layer, col.is_trigger);
+            break;
+        }
+        case ColliderType::Mesh: {
+            queries.set(slot, entry.id, entry.mesh, col.layer, col.is_trigger);
+            break;
+        }
+        default: {
+            throw std::runtime_error("[CollisionDetectionSystem] Unknown collider type!");
         }
     }
+}
 
-    // Test axes M0, M1, M2 (B's local axes)
-    // For A frame onto B axis: proj_a = sum_i (a_he[i] * abs_R[i][j])
-    // For B frame j = proj_b = b_he[j]
-    for (int32_t j = 0; j < 3 && !separated; ++j) {
-        float proj_a = a_he[0] * abs_R[0][j] + a_he[1] * abs_R[1][j] + a_he[2] * abs_R[2][j];
-        float proj_b = b_he[j];
-        // distance = dot(t, rot_mat[:,j]) -> since t is A-frame coords, dot with column j of rot_mat
-        float dist = t[0] * rot_mat[0][j] + t[1] * rot_mat[1][j] + t[2] * rot_mat[2][j];
-        glm::vec3 axis_world = rot_mat_B * glm::vec3((j == 0), (j == 1), (j == 2));  // j-th world axis of B
-        if (!text_axis_fn(axis_world, proj_a, proj_b, dist)) {
-            return false;
+// Order of the shapes in the narrowphase functions taking two different kinds
+static uint32_t shape_rank(ColliderType type) {
+    switch (type) {
+        case ColliderType::Sphere: {
+            return 0;
+        }
+        case ColliderType::Capsule: {
+            return 1;
+        }
+        case ColliderType::OBB: {
+            return 2;
+        }
+        case ColliderType::Convex: {
+            return 3;
+        }
+        default: {
+            throw std::runtime_error("[CollisionDetectionSystem] Unknown collider type!");
         }
     }
+}
 
-    // Test cross product axes (9 tests)
-    for (int32_t i = 0; i < 3 && !separated; ++i) {
-        for (int32_t j = 0; j < 3 && !separated; ++j) {
-            // axis = A_i x B_j (expressed in world)
-            glm::vec3 Ai = rot_mat_A * glm::vec3((i == 0), (i == 1), (i == 2));
-            glm::vec3 Bj = rot_mat_B * glm::vec3((j == 0), (j == 1), (j == 2));
-            glm::vec3 axis_world = cross(Ai, Bj);
-            float axis_len2 = dot(axis_world, axis_world);
-
-            if (axis_len2 < COL_EPS) {
-                continue;
+// Every pair except OBB-OBB, which goes through the SIMD batch first, and meshes.
+// Pairs with a hull go through GJK, starting from `cache`
+static bool mixed_contact(const CollisionEntry& A, const CollisionEntry& B, Contact& c, GjkCache& cache) {
+    bool swapped = shape_rank(A.type) > shape_rank(B.type);
+    const CollisionEntry& X = swapped ? B : A;
+    const CollisionEntry& Y = swapped ? A : B;
+
+    bool hit = false;
+    if (Y.type == ColliderType::Convex) {
+        hit = convex_contact(X.id, X.support_shape(), Y.id, Y.support_shape(), c, &cache);
+    } else if (X.type == ColliderType::Sphere) {
+        switch (Y.type) {
+            case ColliderType::Sphere: {
+                hit = sphere_vs_sphere(X.id, X.sphere, Y.id, Y.sphere, c);
+                break;
             }
-
-            float proj_a = 0.0f;
-            float proj_b = 0.0f;
-
-            // Projection calculation for A
-            for (int32_t k = 0; k < 3; k++) {
-                glm::vec3 Ak = rot_mat_A * glm::vec3((k == 0), (k == 1), (k == 2));
-                float proj = dot(Ak, normalize(axis_world));
-                proj_a += a_he[k] * std::abs(proj);
+            case ColliderType::Capsule: {
+                hit = sphere_vs_capsule(X.id, X.sphere, Y.id, Y.capsule, c);
+                break;
             }
-
-            // Projection calculation for B
-            for (int32_t k = 0; k < 3; k++) {
-                glm::vec3 Bk = rot_mat_B * glm::vec3((k == 0), (k == 1), (k == 2));
-                float proj = dot(Bk, normalize(axis_world));
-                proj_b += b_he[k] * std::abs(proj);
-            }
-
-            float dist = dot(t_world, normalize(axis_world));
-            if (!text_axis_fn(normalize(axis_world), proj_a, proj_b, dist)) {
-                return false;
+            default: {
+                hit = sphere_vs_obb(X.id, X.sphere, Y.id, Y.obb, c);
+                break;
             }
         }
+    } else if (Y.type == ColliderType::Capsule) {
+        hit = capsule_vs_capsule(X.id, X.capsule, Y.id, Y.capsule, c);
+    } else {
+        hit = capsule_vs_obb(X.id, X.capsule, Y.id, Y.obb, c);
+    }
+
+    if (hit && swapped) {
+        // Flip so A->B ordering is consistent
+        std::swap(c.a, c.b);
+        c.normal = -c.normal;
     }
+    return hit;
+}
 
-    if (separated) {
+// Whether a pair with a trigger overlaps, by the cheapest test its triggers allow
+static bool trigger_overlap(const CollisionEntry& A, const CollisionEntry& B, bool obb_overlapping) {
+    if (!aabb_overlap(A.collider_aabb, B.collider_aabb)) {
         return false;
     }
 
-    // Use min_axis (in world space) as approximate contact normal
-    glm::vec3 center_dir = B.center - A.center;
-    if (dot(center_dir, min_axis) < 0.0f) {
-        min_axis = -min_axis;
+    bool bounds_only = (!A.col->is_trigger || A.col->trigger_test == TriggerTest::Bounds) &&
+                       (!B.col->is_trigger || B.col->trigger_test == TriggerTest::Bounds);
+    if (bounds_only) {
+        return true;
     }
 
-    out.a = a;
-    out.b = b;
-    out.normal = normalize(min_axis);
-    out.penetration = min_overlap;
-    // approximate contact position as midway between centers shifted by half penetration along normal
-    out.position = (A.center + B.center) * 0.5f - out.normal * (out.penetration * 0.5f);
-    out.is_trigger = false;
-    return true;
+    if (A.type == ColliderType::Mesh || B.type == ColliderType::Mesh) {
+        const CollisionEntry& X = A.type == ColliderType::Mesh ? B : A;
+        const CollisionEntry& M = A.type == ColliderType::Mesh ? A : B;
+        return X.type != ColliderType::Mesh && shape_overlaps_mesh(X.support_shape(), X.collider_aabb, M.mesh);
+    }
+    if (A.type == ColliderType::OBB && B.type == ColliderType::OBB) {
+        return obb_overlapping;
+    }
+    return convex_overlap(A.support_shape(), B.support_shape());
 }
 
+// Out of line, CollisionEntry is only complete here
+CollisionDetectionSystem::CollisionDetectionSystem() = default;
+CollisionDetectionSystem::~CollisionDetectionSystem() = default;
+
 void CollisionDetectionSystem::init(Engine& engine) {
+    m_cc = engine.cm().ref<CollisionContext>();
+
     EntityManager& em = engine.em();
     AssetManager& am = engine.am();
 
@@ -340,58 +345,475 @@ void CollisionDetectionSystem::init(Engine& engine) {
 }
 
 void CollisionDetectionSystem::update(Engine& engine) {
-    auto& cc = engine.cm().get<CollisionContext>();
+    auto& cc = *m_cc;
 
     EntityManager& em = engine.em();
 
+    IBroadphase& bp = *cc.broadphase;
+
+    // The broadphase was swapped, its proxies start from scratch
+    if (m_broadphase_generation != cc.broadphase_generation) {
+        m_broadphase_generation = cc.broadphase_generation;
+        for (const auto& [_e, ps] : m_proxies) {
+            m_entries[ps.entry] = CollisionEntry{};
+            m_free_entries.push_back(ps.entry);
+        }
+        m_proxies.clear();
+        m_separating_axes.clear();
+        cc.queries.clear();
+    }
+
+    // Last frame's contacts carry the solver's impulses, kept to warm start this frame
+    m_prev_contacts.swap(cc.contacts);
     cc.contacts.clear();
-    std::vector<CollisionEntry> entries;
+    m_prev_index.clear();
+    for (uint32_t i = 0; i < m_prev_contacts.size(); i++) {
+        m_prev_index.emplace(pair_key(m_prev_contacts[i].a, m_prev_contacts[i].b), i);
+    }
+    bp.clear_pair_changes();
+    m_frame++;
+
     for (auto [e, tr, col] : em.entities_with<Transform, Collider>()) {
         if (!col.is_enabled) {
             continue;
         }
 
-        // TODO: filter by layer
-        entries.push_back(CollisionEntry(e, &tr, &col));
+        // Each collider keeps its entry slot while it has a proxy, along with the cached world shape
+        auto [it, added] = m_proxies.try_emplace(e);
+        ProxyState& ps = it->second;
+        if (added) {
+            if (!m_free_entries.empty()) {
+                ps.entry = m_free_entries.back();
+                m_free_entries.pop_back();
+            } else {
+                ps.entry = static_cast<uint32_t>(m_entries.size());
+                m_entries.emplace_back();
+            }
+        }
+        ps.frame = m_frame;
+
+        if ((col.type == ColliderType::Convex && !col.hull) || (col.type == ColliderType::Mesh && !col.mesh)) {
+            build_geometry(engine, e, col);
+        }
+
+        CollisionEntry& entry = m_entries[ps.entry];
+        bool moved = entry.refresh(e, &tr, &col);
+        if (added || moved) {
+            set_query_shape(cc.queries, ps.entry, entry);
+        } else {
+            cc.queries.set_filter(ps.entry, col.layer, col.is_trigger);
+        }
+
+        // Colliders without a dynamic body never move on their own
+        bool was_swept = entry.ccd;
+        bool is_static = true;
+        entry.displacement = glm::vec3(0.0f);
+        entry.ccd = false;
+        entry.frozen = false;
+        if (em.has_component<RigidBody>(e)) {
+            const RigidBody& rb = em.get_component<RigidBody>(e);
+            is_static = rb.is_static;
+            entry.frozen = rb.is_sleeping || rb.lod_skipped;
+
+            if (!rb.is_static && !rb.is_kinematic) {
+                // Velocity is still the one the rigidbody system moved the body with, over its own step
+                entry.displacement = rb.velocity * rb.step_time;
+
+                // A body moving less than its inner radius can't pass through anything unnoticed
+                glm::vec3 center;
+                float radius;
+                entry.inner_sphere(center, radius);
+                entry.ccd = rb.ccd && glm::dot(entry.displacement, entry.displacement) > radius * radius;
+            }
+        }
+        ProxyFilter filter{col.layer, col.collides_with & cc.layers.mask_for(col.layer), is_static};
+
+        // Keep the entity's broadphase proxy in sync, a new filter means a new proxy
+        if (!added && ps.filter != filter) {
+            bp.remove_proxy(ps.proxy);
+            added = true;
+        }
+
+        if (added) {
+            ps.proxy = bp.add_proxy(entry.proxy_aabb(), e, filter);
+            ps.filter = filter;
+        } else if (moved || entry.ccd || was_swept) {
+            bp.move_proxy(ps.proxy, entry.proxy_aabb());
+        }
+        entry.changed = moved || added;
+
+        if (ps.proxy >= m_proxy_entries.size()) {
+            m_proxy_entries.resize(ps.proxy + 1);
+        }
+        m_proxy_entries[ps.proxy] = ps.entry;
+    }
+
+    // Drop the proxies of colliders that were removed or disabled
+    std::erase_if(m_proxies, [&](const auto& kv) {
+        if (kv.second.frame == m_frame) {
+            return false;
+        }
+
+        bp.remove_proxy(kv.second.proxy);
+        cc.queries.remove(kv.second.entry);
+        m_entries[kv.second.entry] = CollisionEntry{};
+        m_free_entries.push_back(kv.second.entry);
+        return true;
+    });
+
+    auto bp_start = std::chrono::steady_clock::now();
+    bp.update_pairs();
+    cc.broadphase_ms =
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - bp_start).count();
+
+    // Separating axes are only kept while their pair lives in the broadphase
+    for (const BroadphasePair& pair : bp.pairs().removed()) {
+        m_separating_axes.erase(pair_key(pair.a, pair.b));
+    }
+
+    const std::vector<BroadphasePair>& pairs = bp.pairs().pairs();
+    auto pair_entries = [&](const BroadphasePair& pair) {
+        uint32_t i = m_proxy_entries[pair.a];
+        uint32_t j = m_proxy_entries[pair.b];
+        return i < j ? std::pair(i, j) : std::pair(j, i);
+    };
+
+    // Nothing about a pair changed when one side is frozen and neither moved, it keeps its contacts
+    auto keeps_contacts = [](const CollisionEntry& A, const CollisionEntry& B) {
+        return (A.frozen || B.frozen) && !A.changed && !B.changed;
+    };
+
+    // Reject separated OBB pairs first on the axis that separated them last frame, which
+    // usually still does, then the rest in SIMD batches
+    m_obb_batch.clear();
+    m_batch_pairs.clear();
+    m_pair_axes.assign(pairs.size(), OBB_NO_AXIS);
+    for (uint32_t p = 0; p < pairs.size(); p++) {
+        auto [i, j] = pair_entries(pairs[p]);
+        if (m_entries[i].type != ColliderType::OBB || m_entries[j].type != ColliderType::OBB ||
+            keeps_contacts(m_entries[i], m_entries[j])) {
+            continue;
+        }
+
+        auto it = m_separating_axes.find(pair_key(pairs[p].a, pairs[p].b));
+        if (it != m_separating_axes.end() && obb_axis_separates(m_entries[i].obb, m_entries[j].obb, it->second)) {
+            m_pair_axes[p] = it->second;
+            continue;
+        }
+
+        m_batch_pairs.push_back(p);
+        m_obb_batch.push(m_entries[i].obb, m_entries[j].obb);
     }
 
-    // Broadphase + narrowphase
-    for (size_t i = 0; i < entries.size(); i++) {
-        for (size_t j = i + 1; j < entries.size(); j++) {
-            CollisionEntry& A = entries[i];
-            CollisionEntry& B = entries[j];
+    m_batch_axes.resize(m_obb_batch.size());
+    parallel_for(m_obb_batch.size(), NARROWPHASE_PARALLEL_GRAIN, [&](uint32_t begin, uint32_t end, uint32_t) {
+        m_obb_batch.test(begin, end, m_batch_axes.data());
+    });
+
+    for (uint32_t k = 0; k < m_batch_pairs.size(); k++) {
+        uint32_t p = m_batch_pairs[k];
+        uint64_t key = pair_key(pairs[p].a, pairs[p].b);
+        m_pair_axes[p] = m_batch_axes[k];
+        if (m_batch_axes[k] == OBB_NO_AXIS) {
+            m_separating_axes.erase(key);
+        } else {
+            m_separating_axes[key] = m_batch_axes[k];
+        }
+    }
 
-            // Layer filtering
-            if ((A.col->collides_with & A.col->layer) == 0) {
-                // TODO: user masking logic
+    // Narrowphase over the broadphase pairs, every chunk into its own buffer
+    uint32_t pair_count = static_cast<uint32_t>(pairs.size());
+    uint32_t chunks = parallel_chunks(pair_count, NARROWPHASE_PARALLEL_GRAIN);
+    m_chunks.resize(std::max<size_t>(m_chunks.size(), chunks));
+    parallel_for(pair_count, NARROWPHASE_PARALLEL_GRAIN, [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+        NarrowphaseChunk& out = m_chunks[chunk];
+        out.contacts.clear();
+        out.ccd_pairs.clear();
+        out.gjk_caches.clear();
+
+        for (uint32_t p = begin; p < end; p++) {
+            auto [i, j] = pair_entries(pairs[p]);
+            const CollisionEntry& A = m_entries[i];
+            const CollisionEntry& B = m_entries[j];
+            if (keeps_contacts(A, B)) {
+                keep_contacts(pair_key(A.id, B.id), out);
+                continue;
             }
 
-            if (!aabb_overlap(A.collider_aabb, B.collider_aabb)) {
+            bool is_trigger = A.col->is_trigger || B.col->is_trigger;
+            bool obb_overlapping =
+                A.type == ColliderType::OBB && B.type == ColliderType::OBB && m_pair_axes[p] == OBB_NO_AXIS;
+
+            // Triggers only report that they overlap, without contact points
+            if (is_trigger) {
+                if (trigger_overlap(A, B, obb_overlapping)) {
+                    Contact c;
+                    c.a = A.id;
+                    c.b = B.id;
+                    c.is_trigger = true;
+                    c.position = (glm::max(A.collider_aabb.min, B.collider_aabb.min) +
+                                  glm::min(A.collider_aabb.max, B.collider_aabb.max)) *
+                                 0.5f;
+                    out.contacts.push_back(c);
+                }
+                continue;
+            }
+
+            // Meshes give a manifold per surface they touch. Two meshes are both static
+            // level geometry and never collide
+            if (A.type == ColliderType::Mesh || B.type == ColliderType::Mesh) {
+                const CollisionEntry& X = A.type == ColliderType::Mesh ? B : A;
+                const CollisionEntry& M = A.type == ColliderType::Mesh ? A : B;
+                uint32_t first = static_cast<uint32_t>(out.contacts.size());
+                if (X.type != ColliderType::Mesh &&
+                    shape_vs_mesh(X.id, X.support_shape(), X.collider_aabb, M.id, M.mesh, out.contacts,
+                                  out.mesh_scratch) > 0) {
+                    for (uint32_t k = first; k < out.contacts.size(); k++) {
+                        warm_start(out.contacts[k]);
+                    }
+                } else if (A.ccd || B.ccd) {
+                    out.ccd_pairs.push_back(std::pair(i, j));
+                }
                 continue;
             }
 
             // Gather contacts
             Contact c;
             bool hit = false;
-            if (A.is_sphere && B.is_sphere) {
-                hit = sphere_vs_sphere(A.id, A.sphere, B.id, B.sphere, c);
-            } else if (A.is_sphere && !B.is_sphere) {
-                hit = sphere_vs_obb(A.id, A.sphere, B.id, B.obb, c);
-            } else if (!A.is_sphere && B.is_sphere) {
-                hit = sphere_vs_obb(B.id, B.sphere, A.id, A.obb, c);
-                if (hit) {
-                    // Flip so A->B ordering is consistent
-                    std::swap(c.a, c.b);
-                    c.normal = -c.normal;
-                }
+            if (A.type == ColliderType::OBB && B.type == ColliderType::OBB) {
+                hit = obb_overlapping && obb_vs_obb(A.id, A.obb, B.id, B.obb, c);
             } else {
-                hit = obb_vs_obb(A.id, A.obb, B.id, B.obb, c);
+                uint64_t key = pair_key(A.id, B.id);
+                auto it = m_gjk_cache.find(key);
+                GjkCache cache = it != m_gjk_cache.end() ? it->second : GjkCache{};
+                hit = mixed_contact(A, B, c, cache);
+                if (A.type == ColliderType::Convex || B.type == ColliderType::Convex) {
+                    out.gjk_caches.push_back(std::pair(key, cache));
+                }
             }
 
             if (hit) {
-                c.is_trigger = (A.col->is_trigger || B.col->is_trigger);
-                cc.contacts.push_back(c);
+                warm_start(c);
+                out.contacts.push_back(c);
+            } else if (A.ccd || B.ccd) {
+                out.ccd_pairs.push_back(std::pair(i, j));
+            }
+        }
+    });
+
+    // Pair order depends on the broadphase's history, sorting makes the contacts
+    // the same for the same scene whatever the thread count
+    m_gjk_cache.clear();
+    for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+        cc.contacts.insert(cc.contacts.end(), m_chunks[chunk].contacts.begin(), m_chunks[chunk].contacts.end());
+        m_gjk_cache.insert(m_chunks[chunk].gjk_caches.begin(), m_chunks[chunk].gjk_caches.end());
+    }
+    sweep_ccd(chunks, cc);
+    std::sort(cc.contacts.begin(), cc.contacts.end(),
+              [](const Contact& x, const Contact& y) { return pair_key(x.a, x.b) < pair_key(y.a, y.b); });
+    track_pairs(cc);
+}
+
+// Both frames' contacts are sorted by pair, walking them side by side tells the
+// pairs that began, persisted and ended
+void CollisionDetectionSystem::track_pairs(CollisionContext& cc) const {
+    const std::vector<Contact>& curr = cc.contacts;
+    const std::vector<Contact>& prev = m_prev_contacts;
+    cc.pairs.clear();
+
+    uint32_t i = 0;
+    uint32_t j = 0;
+    while (i < curr.size() || j < prev.size()) {
+        uint64_t ki = i < curr.size() ? pair_key(curr[i].a, curr[i].b) : 0;
+        uint64_t kj = j < prev.size() ? pair_key(prev[j].a, prev[j].b) : 0;
+        bool in_curr = i < curr.size() && (j == prev.size() || ki <= kj);
+        bool in_prev = j < prev.size() && (i == curr.size() || kj <= ki);
+
+        if (in_curr) {
+            ContactPair pair{curr[i].a, curr[i].b, in_prev ? ContactPhase::Persist : ContactPhase::Begin,
+                             curr[i].is_trigger, i, 0};
+            while (i < curr.size() && pair_key(curr[i].a, curr[i].b) == ki) {
+                pair.count++;
+                i++;
+            }
+            cc.pairs.push_back(pair);
+        } else {
+            cc.pairs.push_back(ContactPair{prev[j].a, prev[j].b, ContactPhase::End, prev[j].is_trigger, 0, 0});
+        }
+
+        while (in_prev && j < prev.size() && pair_key(prev[j].a, prev[j].b) == kj) {
+            j++;
+        }
+    }
+}
+
+// Swept bodies are cast as their inner sphere along their motion relative to the other
+// body, against the other's shape at the end of the step. Each one is moved back to
+// its earliest impact and gets a contact there, which the solver uses to stop it
+void CollisionDetectionSystem::sweep_ccd(uint32_t chunks, CollisionContext& cc) {
+    m_ccd_hits.clear();
+
+    for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+        for (auto [i, j] : m_chunks[chunk].ccd_pairs) {
+            const CollisionEntry& A = m_entries[i];
+            const CollisionEntry& B = m_entries[j];
+            bool a_casts = A.ccd;
+            const CollisionEntry& caster = a_casts ? A : B;
+            const CollisionEntry& other = a_casts ? B : A;
+
+            glm::vec3 motion = caster.displacement - other.displacement;
+            float length = glm::length(motion);
+            if (length <= COL_EPS) {
+                continue;
+            }
+
+            glm::vec3 center;
+            float radius;
+            caster.inner_sphere(center, radius);
+
+            // Touching at the start of the step is left to the discrete test
+            RayHit hit;
+            if (!other.cast(center - motion, motion / length, radius, length, hit) || hit.distance <= 0.0f) {
+                continue;
+            }
+
+            Contact c;
+            c.a = A.id;
+            c.b = B.id;
+            c.normal = a_casts ? -hit.normal : hit.normal;
+            c.position = hit.point;
+            c.points[0] = ContactPoint{hit.point, 0.0f, 0};
+            c.point_count = 1;
+            m_ccd_hits.push_back(CcdHit{a_casts ? i : j, hit.distance / length, motion, c});
+        }
+    }
+
+    std::sort(m_ccd_hits.begin(), m_ccd_hits.end(), [](const CcdHit& x, const CcdHit& y) {
+        return x.entry < y.entry || (x.entry == y.entry && x.toi < y.toi);
+    });
+
+    m_rewound.clear();
+    for (uint32_t k = 0; k < m_ccd_hits.size(); k++) {
+        const CcdHit& h = m_ccd_hits[k];
+        if (k > 0 && m_ccd_hits[k - 1].entry == h.entry) {
+            continue;
+        }
+
+        // Rewind the body to the time of impact and rebuild its world shape there
+        CollisionEntry& entry = m_entries[h.entry];
+        entry.tr->update_position(-h.motion * (1.0f - h.toi));
+        entry.refresh(entry.id, entry.tr, entry.col);
+        set_query_shape(cc.queries, h.entry, entry);
+        m_rewound.push_back(entry.id);
+    }
+    if (m_rewound.empty()) {
+        return;
+    }
+
+    // The body's discrete contacts were found at its end of step position, which it no longer has
+    std::sort(m_rewound.begin(), m_rewound.end());
+    std::erase_if(cc.contacts, [this](const Contact& c) {
+        return !c.is_trigger && (std::binary_search(m_rewound.begin(), m_rewound.end(), c.a) ||
+                                 std::binary_search(m_rewound.begin(), m_rewound.end(), c.b));
+    });
+
+    for (uint32_t k = 0; k < m_ccd_hits.size(); k++) {
+        if (k > 0 && m_ccd_hits[k - 1].entry == m_ccd_hits[k].entry) {
+            continue;
+        }
+
+        Contact c = m_ccd_hits[k].contact;
+        warm_start(c);
+        cc.contacts.push_back(c);
+    }
+}
+
+// Copies last frame's contacts of a pair, impulses included, along with its GJK simplex
+void CollisionDetectionSystem::keep_contacts(uint64_t key, NarrowphaseChunk& out) const {
+    auto it = m_prev_index.find(key);
+    if (it != m_prev_index.end()) {
+        for (uint32_t k = it->second; k < m_prev_contacts.size(); k++) {
+            if (pair_key(m_prev_contacts[k].a, m_prev_contacts[k].b) != key) {
+                break;
+            }
+            out.contacts.push_back(m_prev_contacts[k]);
+        }
+    }
+
+    auto cache = m_gjk_cache.find(key);
+    if (cache != m_gjk_cache.end()) {
+        out.gjk_caches.push_back(*cache);
+    }
+}
+
+void CollisionDetectionSystem::warm_start(Contact& c) const {
+    uint64_t key = pair_key(c.a, c.b);
+    auto it = m_prev_index.find(key);
+    if (it == m_prev_index.end()) {
+        return;
+    }
+
+    // A pair may have had several contacts, sorted after the first one
+    for (uint32_t k = it->second; k < m_prev_contacts.size(); k++) {
+        const Contact& prev = m_prev_contacts[k];
+        if (pair_key(prev.a, prev.b) != key) {
+            break;
+        }
+
+        // Feature ids are relative to the pair's order, a swapped pair starts cold
+        if (prev.a != c.a) {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < c.point_count; i++) {
+            ContactPoint& p = c.points[i];
+            for (uint32_t j = 0; j < prev.point_count; j++) {
+                if (prev.points[j].feature == p.feature) {
+                    p.normal_impulse = prev.points[j].normal_impulse;
+                    p.tangent_impulse = prev.points[j].tangent_impulse;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Convex and mesh colliders left without geometry take their entity's model's
+void CollisionDetectionSystem::build_geometry(Engine& engine, EntityID e, Collider& col) {
+    EntityManager& em = engine.em();
+    AssetManager& am = engine.am();
+    if (!em.has_component<Model>(e)) {
+        throw std::runtime_error("[CollisionDetectionSystem] Convex or mesh collider without geometry or a model!");
+    }
+
+    AssetID model_id = em.get_component<Model>(e).asset_id;
+    const std::vector<AssetID>& mesh_ids = am.get<ModelAsset>(model_id).meshes();
+
+    if (col.type == ColliderType::Convex) {
+        auto it = m_hulls.find(model_id);
+        if (it == m_hulls.end()) {
+            m_hull_points.clear();
+            for (AssetID mesh_id : mesh_ids) {
+                const std::vector<glm::vec3>& positions = am.get<MeshAsset>(mesh_id).positions();
+                m_hull_points.insert(m_hull_points.end(), positions.begin(), positions.end());
+            }
+
+            auto hull = std::make_shared<ConvexHull>();
+            hull->build(m_hull_points);
+            it = m_hulls.emplace(model_id, hull).first;
+        }
+        col.hull = it->second;
+    } else {
+        auto it = m_meshes.find(model_id);
+        if (it == m_meshes.end()) {
+            auto mesh = std::make_shared<TriangleMesh>();
+            for (AssetID mesh_id : mesh_ids) {
+                const MeshAsset& asset = am.get<MeshAsset>(mesh_id);
+                mesh->add(asset.positions(), asset.indices());
             }
+            mesh->build();
+            it = m_meshes.emplace(model_id, mesh).first;
         }
+        col.mesh = it->second;
     }
 }
@@ -6,146 +6,544 @@
 #include "components/player.h"
 #include "contexts/collision_context.h"
 #include "contexts/event_context.h"
+#include "contexts/physics_context.h"
 #include "core/engine.h"
 #include "managers/context_manager.h"
 #include "managers/entity_manager.h"
+#include "core/thread_pool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
 
 #define GROUND_NORMAL_THRESHOLD 0.75f
-#define COR_PER 0.1f  // positional correction percentage
-#define SLOP 0.01f    // penetration allowance
+#define COR_PER 0.1f           // positional correction percentage
+#define COR_MAX_PER 0.8f       // cap on it for bodies stepping over several frames
+#define SLOP 0.01f             // penetration allowance
+#define SOLVER_NO_BODY 0xFFFFFFFFu
+#define SLEEP_VELOCITY 0.05f   // speed under which a body counts as resting
+#define SLEEP_TIME 0.5f        // seconds a whole island must rest before it sleeps
+#define SOLVER_NO_ISLAND 0xFFFFFFFFu
+#define SOLVER_COLOR_MIN_POINTS 256  // islands with fewer contact points are solved whole by one thread
+#define SOLVER_MAX_COLORS 64         // one per bit of a body's mask, contacts left over share a serial color
+#define SOLVER_ISLAND_GRAIN 4        // small islands per thread pool chunk
+#define SOLVER_COLOR_GRAIN 32        // contacts of one color per thread pool chunk
+
+// Impulse from A to B, only written to the bodies it moves
+static void apply_impulse(std::vector<glm::vec3>& v, const std::vector<float>& inv_mass, uint32_t a, uint32_t b,
+                          const glm::vec3& impulse) {
+    if (inv_mass[a] > 0.0f) {
+        v[a] -= impulse * inv_mass[a];
+    }
+    if (inv_mass[b] > 0.0f) {
+        v[b] += impulse * inv_mass[b];
+    }
+}
+
+// Orthonormal tangents for friction, always the same for a given normal so the
+// accumulated tangent impulses stay meaningful from frame to frame
+static void tangent_basis(const glm::vec3& n, glm::vec3& t1, glm::vec3& t2) {
+    glm::vec3 ref = std::abs(n.x) < 0.57735f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    t1 = glm::normalize(glm::cross(n, ref));
+    t2 = glm::cross(n, t1);
+}
+
+void CollisionResolutionSystem::init(Engine& engine) {
+    m_cc = engine.cm().ref<CollisionContext>();
+    m_ec = engine.cm().ref<EventContext>();
+    m_pc = engine.cm().ref<const PhysicsContext>();
+}
 
 void CollisionResolutionSystem::update(Engine& engine) {
-    auto& cc = engine.cm().get<CollisionContext>();
-    auto& ec = engine.cm().get<EventContext>();
+    auto& cc = *m_cc;
+    auto& ec = *m_ec;
 
     EntityManager& em = engine.em();
 
-    for (auto [_e, fpc] : em.entities_with<FPController>()) {
-        fpc.is_grounded = false;
-    }
+    gather_bodies(em);
 
+    m_islands.reset(static_cast<uint32_t>(m_bodies.entity.size()));
     for (const Contact& c : cc.contacts) {
         if (!c.is_trigger) {
-            resolve_phys_contact(em, c);
-            positional_correction(em, c);
+            link_contact(c);
+        }
+    }
+    wake_islands(cc);
+
+    build_rows(cc.contacts);
 
-            // Play collisions sounds
-            auto& col_a = em.get_component<Collider>(c.a);
-            auto& col_b = em.get_component<Collider>(c.b);
+    // Play collisions sounds, once when a pair starts touching
+    for (const ContactPair& p : cc.pairs) {
+        if (p.phase == ContactPhase::Begin && !p.is_trigger) {
+            auto& col_a = em.get_component<Collider>(p.a);
+            auto& col_b = em.get_component<Collider>(p.b);
             if (col_a.layer != Layers::Ground && col_b.layer != Layers::Ground) {
-                ec.emit(CollisionEvent{c.a, c.b});
+                ec.emit(CollisionEvent{p.a, p.b});
             }
         }
     }
 
+    solve(m_pc->solver_iterations);
+    update_sleep(m_pc->dt);
+    scatter();
+
     ec.dispatch();
 }
 
-void CollisionResolutionSystem::resolve_phys_contact(EntityManager& em, const Contact& c) {
-    // Get components
-    if (!em.has_component<RigidBody>(c.a) || !em.has_component<RigidBody>(c.b)) {
+void CollisionResolutionSystem::gather_bodies(EntityManager& em) {
+    SolverBodies& b = m_bodies;
+    b.velocity.clear();
+    b.inv_mass.clear();
+    b.correction.clear();
+    b.rb.clear();
+    b.tr.clear();
+    b.controller.clear();
+    b.entity.clear();
+
+    for (auto [e, tr, rb] : em.entities_with<Transform, RigidBody>()) {
+        if (e >= m_body_index.size()) {
+            m_body_index.resize(e + 1, SOLVER_NO_BODY);
+        }
+        m_body_index[e] = static_cast<uint32_t>(b.entity.size());
+
+        bool dynamic = !rb.is_static && !rb.is_kinematic;
+        b.velocity.push_back(rb.velocity);
+        b.inv_mass.push_back(dynamic ? rb.inv_mass : 0.0f);
+        b.correction.push_back(glm::vec3(0.0f));
+        b.rb.push_back(&rb);
+        b.tr.push_back(&tr);
+        b.controller.push_back(nullptr);
+        b.entity.push_back(e);
+    }
+
+    // Only the player is grounded by its contacts
+    for (auto [e, _p, fpc] : em.entities_with<Player, FPController>()) {
+        fpc.is_grounded = false;
+        if (e < m_body_index.size() && m_body_index[e] != SOLVER_NO_BODY) {
+            b.controller[m_body_index[e]] = &fpc;
+        }
+    }
+}
+
+void CollisionResolutionSystem::link_contact(const Contact& c) {
+    if (c.a >= m_body_index.size() || c.b >= m_body_index.size()) {
         return;
     }
 
-    auto& a_rb = em.get_component<RigidBody>(c.a);
-    auto& b_rb = em.get_component<RigidBody>(c.b);
+    uint32_t a = m_body_index[c.a];
+    uint32_t b = m_body_index[c.b];
+    if (a == SOLVER_NO_BODY || b == SOLVER_NO_BODY) {
+        return;
+    }
 
     // Skip static/static
-    if (a_rb.is_static && b_rb.is_static) {
+    SolverBodies& bodies = m_bodies;
+    if (bodies.rb[a]->is_static && bodies.rb[b]->is_static) {
         return;
     }
 
-    // Determine if one of the two entities is the player
-    bool is_a_player = em.has_component<Player>(c.a);
-    bool is_b_player = em.has_component<Player>(c.b);
+    // Only set grounded when hitting a mostly horizontal surface from above, asleep or not
+    if (bodies.controller[a] && -c.normal.y > GROUND_NORMAL_THRESHOLD) {
+        bodies.controller[a]->is_grounded = true;
+    }
+    if (bodies.controller[b] && c.normal.y > GROUND_NORMAL_THRESHOLD) {
+        bodies.controller[b]->is_grounded = true;
+    }
+
+    // Static and kinematic bodies don't carry impulses from one body to another
+    if (bodies.inv_mass[a] > 0.0f && bodies.inv_mass[b] > 0.0f) {
+        m_islands.link(a, b);
+    }
+}
+
+// A body impulses can't move that moves on its own, e.g. a kinematic platform
+static bool pushes(const RigidBody* rb) {
+    return rb && rb->inv_mass == 0.0f && !rb->is_static && rb->velocity != glm::vec3(0.0f);
+}
 
-    float normal_y_for_player = is_a_player ? -c.normal.y : c.normal.y;  // flip if player is A
-    if (is_a_player || is_b_player) {
-        auto& fpc = em.get_component<FPController>(is_a_player ? c.a : c.b);
+// An island is awake as soon as one of its bodies steps, and pairs that start or stop
+// touching wake both sides: something came in or what held them went away. A moving
+// kinematic body wakes what it keeps touching too, or it would sink into it. Pairs that
+// start or stop touching also step at the finer level of the two, a body at full rate
+// can't sink into a slower one. Islands of bodies their level of detail skipped wait for their step
+void CollisionResolutionSystem::wake_islands(const CollisionContext& cc) {
+    SolverBodies& bodies = m_bodies;
+    for (const ContactPair& p : cc.pairs) {
+        if (p.is_trigger) {
+            continue;
+        }
 
-        // Only set grounded if moving downward and hitting mostly horizontal surface
-        if (normal_y_for_player > GROUND_NORMAL_THRESHOLD) {
-            fpc.is_grounded = true;
+        RigidBody* rbs[2] = {nullptr, nullptr};
+        EntityID es[2] = {p.a, p.b};
+        for (uint32_t k = 0; k < 2; k++) {
+            if (es[k] < m_body_index.size() && m_body_index[es[k]] != SOLVER_NO_BODY) {
+                rbs[k] = bodies.rb[m_body_index[es[k]]];
+            }
+        }
+
+        if (p.phase == ContactPhase::Persist) {
+            for (uint32_t k = 0; k < 2; k++) {
+                if (pushes(rbs[k]) && rbs[1 - k]) {
+                    rbs[1 - k]->wake();
+                }
+            }
+            continue;
+        }
+
+        for (RigidBody* rb : rbs) {
+            if (rb) {
+                rb->wake();
+            }
+        }
+
+        if (rbs[0] && rbs[1] && !rbs[0]->is_static && !rbs[1]->is_static && rbs[0]->lod != rbs[1]->lod) {
+            RigidBody& coarse = rbs[0]->lod > rbs[1]->lod ? *rbs[0] : *rbs[1];
+            coarse.promote(std::min(rbs[0]->lod, rbs[1]->lod));
         }
     }
 
-    // Relative velocity at contact
-    glm::vec3 rv = b_rb.velocity - a_rb.velocity;
-    float vel_along_normal = glm::dot(rv, c.normal);
+    m_islands.build();
+    m_island_awake.assign(m_islands.island_count(), 0);
+    for (uint32_t i = 0; i < bodies.entity.size(); i++) {
+        if (!bodies.rb[i]->is_sleeping && !bodies.rb[i]->lod_skipped) {
+            m_island_awake[m_islands.island_of(i)] = 1;
+        }
+    }
 
-    // Do not resolve separating contacts
-    if (vel_along_normal > 0.0f) {
-        return;
+    for (uint32_t i = 0; i < bodies.entity.size(); i++) {
+        if (m_island_awake[m_islands.island_of(i)]) {
+            bodies.rb[i]->wake();
+        }
     }
+}
 
-    // Restitution
-    float e = std::min(a_rb.restitution, b_rb.restitution);
-    float inv_mass_sum = a_rb.inv_mass + b_rb.inv_mass;
-    if (inv_mass_sum <= 0.0f) {
-        return;
+// Island the contact is solved in, SOLVER_NO_ISLAND when it isn't. Contacts that
+// impulses can't move drop their impulses, sleeping ones keep them for when they wake
+uint32_t CollisionResolutionSystem::contact_island(Contact& c) const {
+    if (c.is_trigger || c.a >= m_body_index.size() || c.b >= m_body_index.size()) {
+        return SOLVER_NO_ISLAND;
     }
 
-    // Compute impulse
-    float j = -(1.0f + e) * vel_along_normal;
-    j /= inv_mass_sum;
-    glm::vec3 impulse = j * c.normal;
+    uint32_t a = m_body_index[c.a];
+    uint32_t b = m_body_index[c.b];
+    if (a == SOLVER_NO_BODY || b == SOLVER_NO_BODY) {
+        return SOLVER_NO_ISLAND;
+    }
 
-    if (!a_rb.is_static && !a_rb.is_kinematic) {
-        a_rb.apply_impulse(-impulse);
+    // Skip static/static
+    const SolverBodies& bodies = m_bodies;
+    if (bodies.rb[a]->is_static && bodies.rb[b]->is_static) {
+        return SOLVER_NO_ISLAND;
     }
-    if (!b_rb.is_static && !b_rb.is_kinematic) {
-        b_rb.apply_impulse(impulse);
+
+    if (bodies.inv_mass[a] + bodies.inv_mass[b] <= 0.0f) {
+        for (uint32_t i = 0; i < c.point_count; i++) {
+            c.points[i].normal_impulse = 0.0f;
+            c.points[i].tangent_impulse = glm::vec2(0.0f);
+        }
+        return SOLVER_NO_ISLAND;
     }
 
-    // Simple friction with approximated Coulomb model
-    glm::vec3 tangent = rv - vel_along_normal * c.normal;
-    float tlen2 = glm::dot(tangent, tangent);
-    if (tlen2 > 1e-8f) {
-        tangent = glm::normalize(tangent);
-        float mu = std::sqrt(a_rb.friction * b_rb.friction);
-        float jt = -glm::dot(rv, tangent);
-        jt /= inv_mass_sum;
+    uint32_t island = m_islands.island_of(bodies.inv_mass[a] > 0.0f ? a : b);
+    return m_island_awake[island] ? island : SOLVER_NO_ISLAND;
+}
+
+// Rows are laid out island by island, so each island is one range of contacts. Large
+// islands are colored and laid out color by color
+void CollisionResolutionSystem::build_rows(std::vector<Contact>& contacts) {
+    SolverRows& r = m_rows;
+    r.a.clear();
+    r.b.clear();
+    r.normal.clear();
+    r.t1.clear();
+    r.t2.clear();
+    r.mass.clear();
+    r.friction.clear();
+    r.bounce.clear();
+    r.normal_impulse.clear();
+    r.tangent_impulse.clear();
+    r.point.clear();
+    m_unit_rows.assign(1, 0);
+    m_small_islands.clear();
+    m_large_islands.clear();
+    m_colors.clear();
 
-        // Clamp friction impulse
-        float jt_max = j * mu;
-        jt = std::clamp(jt, -jt_max, jt_max);
-        glm::vec3 friction_impulse = jt * tangent;
-        if (!a_rb.is_static && !a_rb.is_kinematic) {
-            a_rb.apply_impulse(-friction_impulse);
+    // Counting sort of the contacts by island
+    uint32_t island_count = m_islands.island_count();
+    m_island_first.assign(island_count + 1, 0);
+    m_island_points.assign(island_count, 0);
+    m_contact_island.resize(contacts.size());
+    for (uint32_t k = 0; k < contacts.size(); k++) {
+        uint32_t island = contact_island(contacts[k]);
+        m_contact_island[k] = island;
+        if (island != SOLVER_NO_ISLAND) {
+            m_island_first[island + 1]++;
+            m_island_points[island] += contacts[k].point_count;
         }
-        if (!b_rb.is_static && !b_rb.is_kinematic) {
-            b_rb.apply_impulse(friction_impulse);
+    }
+
+    for (uint32_t i = 0; i < island_count; i++) {
+        m_island_first[i + 1] += m_island_first[i];
+    }
+
+    m_order.resize(m_island_first[island_count]);
+    m_cursor.assign(m_island_first.begin(), m_island_first.end() - 1);
+    for (uint32_t k = 0; k < contacts.size(); k++) {
+        if (m_contact_island[k] != SOLVER_NO_ISLAND) {
+            m_order[m_cursor[m_contact_island[k]]++] = k;
+        }
+    }
+
+    for (uint32_t i = 0; i < island_count; i++) {
+        uint32_t begin = m_island_first[i];
+        uint32_t end = m_island_first[i + 1];
+        if (begin == end) {
+            continue;
+        }
+
+        SolverIsland island{static_cast<uint32_t>(m_unit_rows.size()) - 1, 0, 0, 0};
+        if (m_island_points[i] >= SOLVER_COLOR_MIN_POINTS) {
+            island.first_color = static_cast<uint32_t>(m_colors.size());
+            color_contacts(contacts, begin, end, island.first);
+            island.color_count = static_cast<uint32_t>(m_colors.size()) - island.first_color;
+        }
+
+        for (uint32_t k = begin; k < end; k++) {
+            add_contact(contacts[m_order[k]]);
+            m_unit_rows.push_back(static_cast<uint32_t>(r.point.size()));
+        }
+        island.end = static_cast<uint32_t>(m_unit_rows.size()) - 1;
+
+        if (island.color_count > 0) {
+            m_large_islands.push_back(island);
+        } else {
+            m_small_islands.push_back(island);
         }
     }
 }
 
-void CollisionResolutionSystem::positional_correction(EntityManager& em, const Contact& c) {
-    if (!em.has_components<Transform, RigidBody>(c.a) || !em.has_components<Transform, RigidBody>(c.b)) {
-        return;
+// Greedy coloring, each contact takes the first color neither of its moving bodies has
+// yet. Contacts of one color then share no body that impulses move. Reorders
+// m_order[begin, end) by color, `first_unit` is the unit of the first contact
+void CollisionResolutionSystem::color_contacts(const std::vector<Contact>& contacts, uint32_t begin, uint32_t end,
+                                               uint32_t first_unit) {
+    const SolverBodies& bodies = m_bodies;
+    m_body_colors.resize(bodies.entity.size(), 0);
+
+    uint32_t counts[SOLVER_MAX_COLORS + 1] = {};
+    m_contact_color.resize(end - begin);
+    for (uint32_t k = begin; k < end; k++) {
+        const Contact& c = contacts[m_order[k]];
+        uint32_t a = m_body_index[c.a];
+        uint32_t b = m_body_index[c.b];
+        uint64_t used = (bodies.inv_mass[a] > 0.0f ? m_body_colors[a] : 0) |
+                        (bodies.inv_mass[b] > 0.0f ? m_body_colors[b] : 0);
+
+        uint32_t color = ~used != 0 ? static_cast<uint32_t>(std::countr_zero(~used)) : SOLVER_MAX_COLORS;
+        if (color < SOLVER_MAX_COLORS) {
+            m_body_colors[a] |= bodies.inv_mass[a] > 0.0f ? uint64_t(1) << color : 0;
+            m_body_colors[b] |= bodies.inv_mass[b] > 0.0f ? uint64_t(1) << color : 0;
+        }
+        m_contact_color[k - begin] = color;
+        counts[color]++;
+    }
+
+    // Masks are only kept for this island
+    for (uint32_t k = begin; k < end; k++) {
+        const Contact& c = contacts[m_order[k]];
+        m_body_colors[m_body_index[c.a]] = 0;
+        m_body_colors[m_body_index[c.b]] = 0;
     }
 
-    auto [a_tr, a_rb] = em.get_components<Transform, RigidBody>(c.a);
-    auto [b_tr, b_rb] = em.get_components<Transform, RigidBody>(c.b);
+    uint32_t offsets[SOLVER_MAX_COLORS + 1];
+    uint32_t offset = 0;
+    for (uint32_t color = 0; color <= SOLVER_MAX_COLORS; color++) {
+        offsets[color] = offset;
+        if (counts[color] > 0) {
+            m_colors.push_back(SolverColor{first_unit + offset, first_unit + offset + counts[color],
+                                           color < SOLVER_MAX_COLORS});
+        }
+        offset += counts[color];
+    }
 
-    if (a_rb.is_static && b_rb.is_static) {
-        return;
+    m_sorted.resize(end - begin);
+    for (uint32_t k = begin; k < end; k++) {
+        m_sorted[offsets[m_contact_color[k - begin]]++] = m_order[k];
     }
+    std::copy(m_sorted.begin(), m_sorted.end(), m_order.begin() + begin);
+}
 
-    float inv_mass_sum = a_rb.inv_mass + b_rb.inv_mass;
-    if (inv_mass_sum == 0.0f) {
-        return;
+void CollisionResolutionSystem::add_contact(Contact& c) {
+    SolverBodies& bodies = m_bodies;
+    uint32_t a = m_body_index[c.a];
+    uint32_t b = m_body_index[c.b];
+    const RigidBody& a_rb = *bodies.rb[a];
+    const RigidBody& b_rb = *bodies.rb[b];
+    float inv_mass_sum = bodies.inv_mass[a] + bodies.inv_mass[b];
+
+    glm::vec3 t1, t2;
+    tangent_basis(c.normal, t1, t2);
+    float friction = std::sqrt(a_rb.friction * b_rb.friction);
+
+    // Restitution targets a bounce off the approach speed at the start of the frame
+    float vel_along_normal = glm::dot(bodies.velocity[b] - bodies.velocity[a], c.normal);
+    float e = std::min(a_rb.restitution, b_rb.restitution);
+    float bounce = vel_along_normal < 0.0f ? -e * vel_along_normal : 0.0f;
+
+    SolverRows& r = m_rows;
+    for (uint32_t i = 0; i < c.point_count; i++) {
+        ContactPoint& p = c.points[i];
+        r.a.push_back(a);
+        r.b.push_back(b);
+        r.normal.push_back(c.normal);
+        r.t1.push_back(t1);
+        r.t2.push_back(t2);
+        r.mass.push_back(1.0f / inv_mass_sum);
+        r.friction.push_back(friction);
+        r.bounce.push_back(bounce);
+        r.normal_impulse.push_back(p.normal_impulse);
+        r.tangent_impulse.push_back(p.tangent_impulse);
+        r.point.push_back(&p);
     }
 
-    float correction_mag = std::max(c.penetration - SLOP, 0.0f) / inv_mass_sum * COR_PER;
-    glm::vec3 correction = correction_mag * c.normal;
+    // Pushed apart once per contact, not per point, after the velocities are solved. Bodies
+    // stepping over n frames sink n^2 times as far into what they rest on, and are pushed
+    // out that much harder to rest as deep
+    float frames = std::max(std::max(a_rb.step_time, b_rb.step_time) / m_pc->dt, 1.0f);
+    float percent = std::min(COR_PER * frames * frames, COR_MAX_PER);
+    glm::vec3 correction = std::max(c.penetration - SLOP, 0.0f) / inv_mass_sum * percent * c.normal;
+    bodies.correction[a] -= correction * bodies.inv_mass[a];
+    bodies.correction[b] += correction * bodies.inv_mass[b];
+}
+
+// Islands share no body that impulses move, nor do contacts of one color, so both are
+// solved in parallel. Each contact's points stay on one thread and every row is solved
+// in the same order whatever the thread count
+void CollisionResolutionSystem::solve(uint32_t iterations) {
+    parallel_for(static_cast<uint32_t>(m_small_islands.size()), SOLVER_ISLAND_GRAIN,
+                 [&](uint32_t begin, uint32_t end, uint32_t) {
+                     for (uint32_t i = begin; i < end; i++) {
+                         uint32_t row_begin = m_unit_rows[m_small_islands[i].first];
+                         uint32_t row_end = m_unit_rows[m_small_islands[i].end];
+                         warm_start_rows(row_begin, row_end);
+                         for (uint32_t it = 0; it < iterations; it++) {
+                             solve_rows(row_begin, row_end);
+                         }
+                     }
+                 });
 
-    // move A opposite to the normal
-    if (!a_rb.is_static && !a_rb.is_kinematic) {
-        a_tr.update_position(-correction * a_rb.inv_mass);
+    for (const SolverIsland& island : m_large_islands) {
+        auto for_each_color = [&](auto&& fn) {
+            for (uint32_t k = island.first_color; k < island.first_color + island.color_count; k++) {
+                const SolverColor& color = m_colors[k];
+                uint32_t count = color.end - color.first;
+                parallel_for(count, color.parallel ? SOLVER_COLOR_GRAIN : count,
+                             [&](uint32_t begin, uint32_t end, uint32_t) {
+                                 fn(m_unit_rows[color.first + begin], m_unit_rows[color.first + end]);
+                             });
+            }
+        };
+
+        for_each_color([&](uint32_t begin, uint32_t end) { warm_start_rows(begin, end); });
+        for (uint32_t it = 0; it < iterations; it++) {
+            for_each_color([&](uint32_t begin, uint32_t end) { solve_rows(begin, end); });
+        }
+    }
+}
+
+// Last frame's impulses first, then refine them. Bodies impulses don't move may be
+// shared between threads, they are only read
+void CollisionResolutionSystem::warm_start_rows(uint32_t begin, uint32_t end) {
+    const SolverRows& r = m_rows;
+    std::vector<glm::vec3>& v = m_bodies.velocity;
+    const std::vector<float>& inv_mass = m_bodies.inv_mass;
+
+    for (uint32_t i = begin; i < end; i++) {
+        glm::vec3 impulse = r.normal[i] * r.normal_impulse[i] + r.t1[i] * r.tangent_impulse[i].x +
+                            r.t2[i] * r.tangent_impulse[i].y;
+        apply_impulse(v, inv_mass, r.a[i], r.b[i], impulse);
+    }
+}
+
+void CollisionResolutionSystem::solve_rows(uint32_t begin, uint32_t end) {
+    SolverRows& r = m_rows;
+    std::vector<glm::vec3>& v = m_bodies.velocity;
+    const std::vector<float>& inv_mass = m_bodies.inv_mass;
+
+    for (uint32_t i = begin; i < end; i++) {
+        uint32_t a = r.a[i];
+        uint32_t b = r.b[i];
+
+        // Normal impulse, the accumulated total can only push
+        float vel_along_normal = glm::dot(v[b] - v[a], r.normal[i]);
+        float old_impulse = r.normal_impulse[i];
+        r.normal_impulse[i] = std::max(old_impulse + (r.bounce[i] - vel_along_normal) * r.mass[i], 0.0f);
+        apply_impulse(v, inv_mass, a, b, r.normal[i] * (r.normal_impulse[i] - old_impulse));
+
+        // Friction along both tangents, bounded by the normal impulse (Coulomb)
+        glm::vec3 rv = v[b] - v[a];
+        float jt_max = r.friction[i] * r.normal_impulse[i];
+        glm::vec2 old_tangent = r.tangent_impulse[i];
+        glm::vec2 lambda_t(-glm::dot(rv, r.t1[i]), -glm::dot(rv, r.t2[i]));
+        r.tangent_impulse[i] = glm::clamp(old_tangent + lambda_t * r.mass[i], -jt_max, jt_max);
+
+        glm::vec2 dt = r.tangent_impulse[i] - old_tangent;
+        apply_impulse(v, inv_mass, a, b, r.t1[i] * dt.x + r.t2[i] * dt.y);
+    }
+}
+
+// Islands sleep once every body in them has rested long enough, all at once so
+// none is left resting on a body that still moves
+void CollisionResolutionSystem::update_sleep(float dt) {
+    SolverBodies& bodies = m_bodies;
+    for (uint32_t island = 0; island < m_islands.island_count(); island++) {
+        if (!m_island_awake[island]) {
+            continue;
+        }
+
+        float rested = FLT_MAX;
+        for (uint32_t i : m_islands.bodies(island)) {
+            RigidBody& rb = *bodies.rb[i];
+            if (bodies.inv_mass[i] <= 0.0f) {
+                continue;
+            }
+
+            const glm::vec3& v = bodies.velocity[i];
+            if (!rb.can_sleep || glm::dot(v, v) > SLEEP_VELOCITY * SLEEP_VELOCITY) {
+                rb.sleep_timer = 0.0f;
+            } else {
+                rb.sleep_timer += dt;
+            }
+            rested = std::min(rested, rb.sleep_timer);
+        }
+
+        if (rested < SLEEP_TIME) {
+            continue;
+        }
+
+        for (uint32_t i : m_islands.bodies(island)) {
+            if (bodies.inv_mass[i] > 0.0f) {
+                bodies.rb[i]->is_sleeping = true;
+                bodies.velocity[i] = glm::vec3(0.0f);
+                bodies.correction[i] = glm::vec3(0.0f);
+            }
+        }
+    }
+}
+
+void CollisionResolutionSystem::scatter() {
+    SolverBodies& b = m_bodies;
+    for (uint32_t i = 0; i < b.entity.size(); i++) {
+        if (b.inv_mass[i] > 0.0f) {
+            b.rb[i]->velocity = b.velocity[i];
+            b.tr[i]->update_position(b.correction[i]);
+        }
+        m_body_index[b.entity[i]] = SOLVER_NO_BODY;
     }
 
-    // move B along the normal
-    if (!b_rb.is_static && !b_rb.is_kinematic) {
-        b_tr.update_position(correction * b_rb.inv_mass);
+    const SolverRows& r = m_rows;
+    for (uint32_t i = 0; i < r.point.size(); i++) {
+        r.point[i]->normal_impulse = r.normal_impulse[i];
+        r.point[i]->tangent_impulse = r.tangent_impulse[i];
     }
 }
@@ -16,8 +16,14 @@
 #include <glm/gtc/quaternion.hpp>
 #include <imgui/imgui.h>
 
+#define FPC_REST_SPEED 1e-3f  // horizontal speed below which the body is considered at rest
+
 void FirstPersonControllerSystem::init(Engine& engine) {
-    auto& ic = engine.cm().get<InputContext>();
+    m_ic = engine.cm().ref<InputContext>();
+    m_ec = engine.cm().ref<EventContext>();
+    m_ec->set_policy<MoveEvent>(EventPolicy{.mode = Coalesce::LatestPerKey});
+
+    auto& ic = *m_ic;
 
     ic.register_action("MoveLeft", InputType::Key, GLFW_KEY_A);
     ic.register_action("MoveRight", InputType::Key, GLFW_KEY_D);
@@ -27,8 +33,8 @@ void FirstPersonControllerSystem::init(Engine& engine) {
 }
 
 void FirstPersonControllerSystem::update(Engine& engine) {
-    auto& ic = engine.cm().get<InputContext>();
-    auto& ec = engine.cm().get<EventContext>();
+    auto& ic = *m_ic;
+    auto& ec = *m_ec;
 
     EntityManager& em = engine.em();
 
@@ -69,8 +75,16 @@ void FirstPersonControllerSystem::update(Engine& engine) {
         }
 
         // Normalize to avoid faster diagonal movement
-        move_dir = glm::normalize(move_dir);
-        ec.emit(MoveEvent{e, std::move(move_dir)});
+        bool is_moving = glm::dot(move_dir, move_dir) > 0.0f;
+        if (is_moving) {
+            move_dir = glm::normalize(move_dir);
+        }
+
+        // Without input a MoveEvent only matters while the body still has to brake
+        glm::vec3 horiz_vel(rb.velocity.x, 0.0f, rb.velocity.z);
+        if (is_moving || glm::dot(horiz_vel, horiz_vel) > FPC_REST_SPEED * FPC_REST_SPEED) {
+            ec.emit(MoveEvent{e, std::move(move_dir)});
+        }
 
         if (ic.was_action_pressed("Jump") && fpc.is_grounded) {
             ec.emit(JumpEvent{e});
@@ -26,9 +26,14 @@
 #include <imgui/backends/imgui_impl_opengl3.h>
 
 void RenderSystem::init(Engine& engine) {
-    auto& rc = engine.cm().get<RenderContext>();
-    auto& ic = engine.cm().get<InputContext>();
-    auto& dc = engine.cm().get<DebugContext>();
+    m_rc = engine.cm().ref<RenderContext>();
+    m_cc = engine.cm().ref<const CameraContext>();
+    m_dc = engine.cm().ref<DebugContext>();
+    m_ic = engine.cm().ref<InputContext>();
+
+    auto& rc = *m_rc;
+    auto& ic = *m_ic;
+    auto& dc = *m_dc;
 
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
@@ -42,9 +47,9 @@ void RenderSystem::init(Engine& engine) {
 }
 
 void RenderSystem::update(Engine& engine) {
-    auto& rc = engine.cm().get<RenderContext>();
-    auto& cc = engine.cm().get<CameraContext>();
-    auto& dc = engine.cm().get<DebugContext>();
+    auto& rc = *m_rc;
+    auto& cc = *m_cc;
+    auto& dc = *m_dc;
 
     EntityManager& em = engine.em();
     AssetManager& am = engine.am();
@@ -174,12 +179,20 @@ void RenderSystem::render_gui(EntityManager& em, RenderContext& rc, DebugContext
     for (auto [e, tr] : em.entities_with<Transform>()) {
         const std::string& name = em.get_name(e);
         ImGui::Text(name.c_str());
-        ImGui::SliderFloat3(("Position##" + std::to_string(e)).c_str(), glm::value_ptr(tr.position_mut()), -100.0f,
-                            100.0f);
-        ImGui::SliderFloat3(("Scale##" + std::to_string(e)).c_str(), glm::value_ptr(tr.scale_mut()), 0.1f, 50.0f,
-                            "%.1f");
+        // Edited on copies, writing through position_mut() would count as a change every frame
+        glm::vec3 position = tr.position();
+        if (ImGui::SliderFloat3(("Position##" + std::to_string(e)).c_str(), glm::value_ptr(position), -100.0f,
+                                100.0f)) {
+            tr.set_position(position);
+        }
+        glm::vec3 scale = tr.scale();
+        bool scaled = ImGui::SliderFloat3(("Scale##" + std::to_string(e)).c_str(), glm::value_ptr(scale), 0.1f, 50.0f,
+                                          "%.1f");
         ImGui::SameLine();
-        ImGui::InputFloat3(("##ScaleInput" + std::to_string(e)).c_str(), glm::value_ptr(tr.scale_mut()), "%.1f");
+        scaled |= ImGui::InputFloat3(("##ScaleInput" + std::to_string(e)).c_str(), glm::value_ptr(scale), "%.1f");
+        if (scaled) {
+            tr.set_scale(scale);
+        }
     }
     ImGui::EndChild();
     ImGui::End();
@@ -2,88 +2,303 @@
 #include "components/transform.h"
 #include "components/rigidbody.h"
 #include "components/fp_controller.h"
+#include "components/camera.h"
+#include "components/sound_listener.h"
 #include "contexts/physics_context.h"
 #include "contexts/event_context.h"
 #include "core/engine.h"
 #include "managers/context_manager.h"
 #include "managers/entity_manager.h"
+#include "physics/simd.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 
 #define RB_EPS 1e-6f
 #define JMSRF 0.65f                // Jumping movement speed reduction factor
 #define BRAKE_ACCEL 20.0f          // m/s^2 large to stop quickly
 #define STOP_SPEED_THRESHOLD 0.2f  // below this, snap to zero
+#define RB_NO_BODY 0xFFFFFFFFu
+#define RB_LOD_VISIBLE_RADIUS 1.0f  // bodies are tested against the view frustum as spheres this big
+
+// Fields of RigidBodySystem::m_fields
+enum BodyField : uint32_t {
+    VX = 0,
+    VY = 1,
+    VZ = 2,
+    FX = 3,
+    FY = 4,
+    FZ = 5,
+    DX = 6,  // position change, written by the kernel
+    DY = 7,
+    DZ = 8,
+    INV_MASS = 9,
+    DAMPING = 10,  // velocity factor over the step
+    FALLS = 11,    // 1 when forces and gravity apply, 0 for grounded controllers
+    MOVES = 12,    // 1 for awake dynamic bodies, the only ones integrated
+    KEEPS = 13,    // 0 for static bodies, whose velocity is zeroed
+    STEP = 14,     // time integrated over, longer for bodies at a lower level of detail
+};
+
+// Semi-implicit Euler over V::WIDTH bodies starting at `first`. The flags select
+// what happens to each body, with no branch per body
+template <typename V>
+static void integrate_kernel(std::array<std::vector<float>, RigidBodySystem::BODY_FIELDS>& fields, uint32_t first,
+                             const glm::vec3& gravity) {
+    auto field = [&](uint32_t f) { return V::load(fields[f].data() + first); };
+
+    V zero = V::set(0.0f);
+    V step = field(STEP);
+    V inv_mass = field(INV_MASS);
+    V damping = field(DAMPING);
+    V falls = field(FALLS);
+    typename V::Mask has_mass = V::lt(zero, inv_mass);
+    typename V::Mask moves = V::lt(zero, field(MOVES));
+    typename V::Mask keeps = V::lt(zero, field(KEEPS));
+
+    for (uint32_t k = 0; k < 3; k++) {
+        V v = field(VX + k);
+        V g = V::select(has_mass, V::set(gravity[k]), zero);
+        V acceleration = (field(FX + k) * inv_mass + g) * falls;
+        V integrated = (v + acceleration * step) * damping;
+
+        v = V::select(keeps, V::select(moves, integrated, v), zero);
+        v.store(fields[VX + k].data() + first);
+        V::select(moves, v * step, zero).store(fields[DX + k].data() + first);
+    }
+}
 
 void RigidBodySystem::init(Engine& engine) {
-    auto& pc = engine.cm().get<PhysicsContext>();
-    auto& ec = engine.cm().get<EventContext>();
+    m_pc = engine.cm().ref<const PhysicsContext>();
+    m_ec = engine.cm().ref<EventContext>();
+
+    auto& ec = *m_ec;
 
     EntityManager& em = engine.em();
 
-    ec.subscribe<MoveEvent>([&](const MoveEvent& e) {
-        auto [rb, fpc] = em.get_components<RigidBody, FPController>(e.entity);
-
-        // Current horizontal velocity and speed
-        glm::vec3 horiz_vel = rb.velocity;
-        horiz_vel.y = 0.0f;
-        float speed = glm::length(horiz_vel);
-
-        const glm::vec3& move_dir = e.direction;
-        bool is_moving = glm::dot(move_dir, move_dir) > RB_EPS;
-        glm::vec3 dv;
-        if (is_moving) {
-            glm::vec3 desired_vel_h = move_dir * fpc.move_speed;
-            if (!fpc.is_grounded) {
-                desired_vel_h *= JMSRF;
-            }
-            dv = desired_vel_h - horiz_vel;
-        } else {
-            float max_dv = BRAKE_ACCEL * pc.dt;
+    ec.subscribe<MoveEvent>([&](std::span<const MoveEvent> events) {
+        for (const MoveEvent& e : events) {
+            auto [rb, fpc] = em.get_components<RigidBody, FPController>(e.entity);
+
+            // Current horizontal velocity and speed
+            glm::vec3 horiz_vel = rb.velocity;
+            horiz_vel.y = 0.0f;
+            float speed = glm::length(horiz_vel);
 
-            if (speed <= STOP_SPEED_THRESHOLD) {
-                rb.apply_impulse(-horiz_vel * rb.mass);
+            const glm::vec3& move_dir = e.direction;
+            bool is_moving = glm::dot(move_dir, move_dir) > RB_EPS;
+            glm::vec3 dv(0.0f);
+            if (is_moving) {
+                glm::vec3 desired_vel_h = move_dir * fpc.move_speed;
+                if (!fpc.is_grounded) {
+                    desired_vel_h *= JMSRF;
+                }
+                dv = desired_vel_h - horiz_vel;
             } else {
-                // reduce speed by up to max_dv
-                dv = -horiz_vel * (max_dv / speed);
+                float max_dv = BRAKE_ACCEL * m_pc->dt;
+
+                if (speed <= STOP_SPEED_THRESHOLD) {
+                    rb.apply_impulse(-horiz_vel * rb.mass);
+                } else {
+                    // reduce speed by up to max_dv
+                    dv = -horiz_vel * (max_dv / speed);
+                }
             }
-        }
 
-        rb.apply_impulse(dv * rb.mass);
+            rb.apply_impulse(dv * rb.mass);
+        }
     });
 
-    ec.subscribe<JumpEvent>([&](const JumpEvent& e) {
-        auto [rb, fpc] = em.get_components<RigidBody, FPController>(e.entity);
-        rb.apply_impulse(glm::vec3(0.0f, fpc.jump_speed * rb.mass, 0.0f));
-        fpc.is_grounded = false;
+    ec.subscribe<JumpEvent>([&](std::span<const JumpEvent> events) {
+        for (const JumpEvent& e : events) {
+            auto [rb, fpc] = em.get_components<RigidBody, FPController>(e.entity);
+            rb.apply_impulse(glm::vec3(0.0f, fpc.jump_speed * rb.mass, 0.0f));
+            fpc.is_grounded = false;
+        }
     });
 }
 
 void RigidBodySystem::update(Engine& engine) {
-    auto& pc = engine.cm().get<PhysicsContext>();
+    auto& pc = *m_pc;
 
     EntityManager& em = engine.em();
+    if (em.structure_version() != m_structure_version) {
+        collect(em);
+    }
+
+    gather(pc);
+    integrate(pc.gravity);
+    scatter();
+    m_frame++;
+}
+
+void RigidBodySystem::collect(EntityManager& em) {
+    m_rbs.clear();
+    m_trs.clear();
+    m_controllers.clear();
 
     for (auto [e, tr, rb] : em.entities_with<Transform, RigidBody>()) {
-        // Skip static bodies
-        if (rb.is_static) {
-            rb.velocity = glm::vec3(0.0f);
-            rb.clear_forces();
-            continue;
+        if (e >= m_body_index.size()) {
+            m_body_index.resize(e + 1, RB_NO_BODY);
         }
+        m_body_index[e] = static_cast<uint32_t>(m_rbs.size());
+        m_rbs.push_back(&rb);
+        m_trs.push_back(&tr);
+    }
 
-        // Skip kinematic as well
-        if (rb.is_kinematic) {
-            rb.clear_forces();
+    for (auto [e, fpc] : em.entities_with<FPController>()) {
+        if (e < m_body_index.size() && m_body_index[e] != RB_NO_BODY) {
+            m_controllers.push_back(std::pair(m_body_index[e], &fpc));
+        }
+    }
+
+    std::fill(m_body_index.begin(), m_body_index.end(), RB_NO_BODY);
+
+    m_cameras.clear();
+    m_listeners.clear();
+    for (auto [_e, cam] : em.entities_with<Camera>()) {
+        m_cameras.push_back(&cam);
+    }
+    for (auto [_e, sl, tr] : em.entities_with<SoundListener, Transform>()) {
+        m_listeners.push_back(&tr);
+    }
+
+    m_structure_version = em.structure_version();
+}
+
+void RigidBodySystem::gather(const PhysicsContext& pc) {
+    uint32_t count = static_cast<uint32_t>(m_rbs.size());
+    for (std::vector<float>& f : m_fields) {
+        f.resize(count);
+    }
+
+    m_observers.clear();
+    if (pc.lod_enabled) {
+        for (Camera* cam : m_cameras) {
+            if (cam->is_active) {
+                m_observers.push_back(cam->world_position());
+            }
+        }
+        for (Transform* tr : m_listeners) {
+            m_observers.push_back(tr->position());
+        }
+    }
+
+    // Most bodies share a damping and a step, the factor is only recomputed when they change
+    float damping = 0.0f;
+    float step = 0.0f;
+    float factor = 1.0f;
+
+    for (uint32_t i = 0; i < count; i++) {
+        RigidBody& rb = *m_rbs[i];
+        bool moves = !rb.is_static && !rb.is_kinematic && !rb.is_sleeping;
+
+        // Bodies at level n step every 2^n frames, all on the same frames so that a pile
+        // at one level steps together and its islands aren't solved every frame
+        rb.step_time = 0.0f;
+        rb.lod_skipped = false;
+        if (moves) {
+            uint8_t level = m_observers.empty() ? 0 : lod_level(pc, m_trs[i]->position());
+            if (rb.lod_hold > 0.0f) {
+                rb.lod_hold = std::max(rb.lod_hold - pc.dt, 0.0f);
+                rb.lod = std::min(rb.lod, level);
+            } else {
+                rb.lod = level;
+            }
+
+            rb.lod_time += pc.dt;
+            rb.lod_skipped = (m_frame & ((1u << rb.lod) - 1)) != 0;
+            if (!rb.lod_skipped) {
+                rb.step_time = rb.lod_time;
+                rb.lod_time = 0.0f;
+            }
+        } else {
+            rb.lod_time = 0.0f;
+        }
+
+        if (rb.linear_damping != damping || rb.step_time != step) {
+            damping = rb.linear_damping;
+            step = rb.step_time;
+            factor = std::exp(-damping * step);
+        }
+
+        for (uint32_t k = 0; k < 3; k++) {
+            m_fields[VX + k][i] = rb.velocity[k];
+            m_fields[FX + k][i] = rb.force_accum[k];
+        }
+        m_fields[INV_MASS][i] = rb.inv_mass;
+        m_fields[DAMPING][i] = factor;
+        m_fields[FALLS][i] = 1.0f;
+        m_fields[MOVES][i] = moves && !rb.lod_skipped ? 1.0f : 0.0f;
+        m_fields[KEEPS][i] = rb.is_static ? 0.0f : 1.0f;
+        m_fields[STEP][i] = rb.step_time;
+    }
+
+    // No gravity for a grounded player
+    for (auto [body, fpc] : m_controllers) {
+        if (fpc->is_grounded) {
+            m_fields[FALLS][body] = 0.0f;
+        }
+    }
+}
+
+// One level per distance passed from the closest observer, closer for bodies out of view
+uint8_t RigidBodySystem::lod_level(const PhysicsContext& pc, const glm::vec3& position) {
+    float dist2 = FLT_MAX;
+    for (const glm::vec3& o : m_observers) {
+        glm::vec3 d = position - o;
+        dist2 = std::min(dist2, glm::dot(d, d));
+    }
+
+    // Without an active camera, e.g. with only a listener, nothing counts as hidden
+    bool visible = true;
+    for (Camera* cam : m_cameras) {
+        if (!cam->is_active) {
             continue;
         }
+        visible = cam->frustum().is_sphere_visible(position, RB_LOD_VISIBLE_RADIUS);
+        if (visible) {
+            break;
+        }
+    }
 
-        // Apply gravity (not to a grounded player)
-        bool is_grounded = em.has_component<FPController>(e) && em.get_component<FPController>(e).is_grounded;
-        if (!is_grounded) {
-            rb.apply_force(pc.gravity * rb.mass, pc.dt);
+    float scale = visible ? 1.0f : pc.lod_hidden_scale;
+    uint8_t level = 0;
+    for (uint32_t n = 0; n + 1 < PHYSICS_LOD_LEVELS; n++) {
+        float distance = pc.lod_distances[n] * scale;
+        if (dist2 > distance * distance) {
+            level = static_cast<uint8_t>(n + 1);
         }
+    }
+    return level;
+}
+
+void RigidBodySystem::integrate(const glm::vec3& gravity) {
+    uint32_t count = static_cast<uint32_t>(m_rbs.size());
+    uint32_t i = 0;
+#ifdef __AVX__
+    for (; i + F32x8::WIDTH <= count; i += F32x8::WIDTH) {
+        integrate_kernel<F32x8>(m_fields, i, gravity);
+    }
+#endif
+#ifdef SIMD_HAS_SSE2
+    for (; i + F32x4::WIDTH <= count; i += F32x4::WIDTH) {
+        integrate_kernel<F32x4>(m_fields, i, gravity);
+    }
+#endif
+    for (; i < count; i++) {
+        integrate_kernel<F32x1>(m_fields, i, gravity);
+    }
+}
 
-        rb.apply_damping(pc.dt);
-        tr.update_position(rb.velocity * pc.dt);
+void RigidBodySystem::scatter() {
+    for (uint32_t i = 0; i < m_rbs.size(); i++) {
+        RigidBody& rb = *m_rbs[i];
+        rb.velocity = glm::vec3(m_fields[VX][i], m_fields[VY][i], m_fields[VZ][i]);
+        if (m_fields[MOVES][i] > 0.0f) {
+            m_trs[i]->update_position(glm::vec3(m_fields[DX][i], m_fields[DY][i], m_fields[DZ][i]));
+        }
         rb.clear_forces();
     }
-}
\ No newline at end of file
+}
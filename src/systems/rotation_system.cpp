@@ -9,8 +9,12 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+void RotationSystem::init(Engine& engine) {
+    m_pc = engine.cm().ref<const PhysicsContext>();
+}
+
 void RotationSystem::update(Engine& engine) {
-    auto& pc = engine.cm().get<PhysicsContext>();
+    auto& pc = *m_pc;
 
     EntityManager& em = engine.em();
 
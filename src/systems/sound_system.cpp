@@ -29,27 +29,33 @@ bool play_sound(AssetManager& am, SoundSource& ss, const std::string& name) {
 }
 
 void SoundSystem::init(Engine& engine) {
-    auto& ec = engine.cm().get<EventContext>();
+    m_ec = engine.cm().ref<EventContext>();
+
+    auto& ec = *m_ec;
 
     EntityManager& em = engine.em();
     AssetManager& am = engine.am();
 
-    ec.subscribe<CollisionEvent>([&](const CollisionEvent& e) {
-        if (em.has_component<SoundSource>(e.a)) {
-            auto& ss = em.get_component<SoundSource>(e.a);
-            play_sound(am, ss, "Collision");
-        }
+    ec.subscribe<CollisionEvent>([&](std::span<const CollisionEvent> events) {
+        for (const CollisionEvent& e : events) {
+            if (em.has_component<SoundSource>(e.a)) {
+                auto& ss = em.get_component<SoundSource>(e.a);
+                play_sound(am, ss, "Collision");
+            }
 
-        if (em.has_component<SoundSource>(e.b)) {
-            auto& ss = em.get_component<SoundSource>(e.b);
-            play_sound(am, ss, "Collision");
+            if (em.has_component<SoundSource>(e.b)) {
+                auto& ss = em.get_component<SoundSource>(e.b);
+                play_sound(am, ss, "Collision");
+            }
         }
     });
 
-    ec.subscribe<JumpEvent>([&](const JumpEvent& e) {
-        if (em.has_component<SoundSource>(e.entity)) {
-            auto& ss = em.get_component<SoundSource>(e.entity);
-            play_sound(am, ss, "Jump");
+    ec.subscribe<JumpEvent>([&](std::span<const JumpEvent> events) {
+        for (const JumpEvent& e : events) {
+            if (em.has_component<SoundSource>(e.entity)) {
+                auto& ss = em.get_component<SoundSource>(e.entity);
+                play_sound(am, ss, "Jump");
+            }
         }
     });
 }
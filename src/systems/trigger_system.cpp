@@ -1,22 +1,40 @@
 #include "systems/trigger_system.h"
+#include "components/collider.h"
 #include "contexts/collision_context.h"
 #include "core/types/contact.h"
 #include "core/engine.h"
 #include "managers/context_manager.h"
 #include "managers/entity_manager.h"
 
+void TriggerSystem::init(Engine& engine) {
+    m_cc = engine.cm().ref<const CollisionContext>();
+}
+
 void TriggerSystem::update(Engine& engine) {
-    auto& cc = engine.cm().get<CollisionContext>();
+    auto& cc = *m_cc;
 
     EntityManager& em = engine.em();
 
-    for (const Contact& c : cc.contacts) {
-        if (c.is_trigger) {
-            resolve_trigger_contact(em, c);
+    for (const ContactPair& p : cc.pairs) {
+        if (p.phase == ContactPhase::Persist) {
+            continue;
         }
+
+        std::span<const Contact> contacts(cc.contacts.data() + p.first, p.count);
+        notify(em, p.a, p, contacts);
+        notify(em, p.b, p, contacts);
     }
 }
 
-void TriggerSystem::resolve_trigger_contact(EntityManager& /*em*/, const Contact& /*c*/) {
-    // TODO
-}
\ No newline at end of file
+void TriggerSystem::notify(EntityManager& em, EntityID e, const ContactPair& pair,
+                           std::span<const Contact> contacts) {
+    // A pair ends when one of its entities is destroyed too
+    if (!em.has_component<Collider>(e)) {
+        return;
+    }
+
+    const Collider& col = em.get_component<Collider>(e);
+    if (col.on_collision) {
+        col.on_collision(pair, contacts);
+    }
+}
@@ -0,0 +1,96 @@
+// gjk_distance() between points and boxes against the exact distance, starting cold,
+// from the previous query's cache and from caches seeded with arbitrary box vertices
+
+#include "physics/gjk.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#define TEST_QUERIES 200000
+#define TEST_TOLERANCE 1e-3f  // relative to the distance, at least 1
+
+static WorldOBB random_box(std::mt19937& rng) {
+    std::uniform_real_distribution<float> U(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> S(0.1f, 3.0f);
+
+    WorldOBB o;
+    o.center = glm::vec3(U(rng), U(rng), U(rng)) * 2.0f;
+    o.half_extents = glm::vec3(S(rng), S(rng), S(rng));
+    glm::mat3 m = glm::mat3_cast(glm::normalize(glm::quat(U(rng), U(rng), U(rng), U(rng))));
+    for (uint32_t k = 0; k < 3; k++) {
+        o.axes[k] = glm::normalize(m[k]);
+    }
+    return o;
+}
+
+static float exact_distance(const glm::vec3& p, const WorldOBB& o) {
+    glm::vec3 d = p - o.center;
+    glm::vec3 outside(0.0f);
+    for (uint32_t k = 0; k < 3; k++) {
+        float x = glm::dot(d, o.axes[k]);
+        outside[k] = std::max(std::abs(x) - o.half_extents[k], 0.0f);
+    }
+    return glm::length(outside);
+}
+
+int main() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> U(-1.0f, 1.0f);
+
+    const char* names[3] = {"cold", "previous cache", "seeded cache"};
+    uint32_t failures[3] = {0, 0, 0};
+    uint32_t tested = 0;
+    GjkCache previous;
+
+    for (uint32_t q = 0; q < TEST_QUERIES; q++) {
+        WorldOBB box = random_box(rng);
+        glm::vec3 p = glm::vec3(U(rng), U(rng), U(rng)) * 8.0f;
+        float expected = exact_distance(p, box);
+        if (expected < 0.01f) {
+            continue;
+        }
+        tested++;
+
+        // Up to three distinct box corners, the point only has one vertex
+        uint32_t corners[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+        std::shuffle(corners, corners + 8, rng);
+        GjkCache seeded;
+        seeded.count = 1 + rng() % 3;
+        for (uint32_t i = 0; i < seeded.count; i++) {
+            seeded.a[i] = 0;
+            seeded.b[i] = corners[i];
+        }
+
+        WorldSphere point;
+        point.center = p;
+        point.radius = 0.0f;
+        SupportShape A(point);
+        SupportShape B(box);
+
+        GjkCache* caches[3] = {nullptr, &previous, &seeded};
+        for (uint32_t c = 0; c < 3; c++) {
+            GjkSimplex simplex;
+            float distance = 0.0f;
+            glm::vec3 pa, pb;
+            bool separated = gjk_distance(A, B, simplex, distance, pa, pb, caches[c]);
+
+            float tolerance = TEST_TOLERANCE * std::max(expected, 1.0f);
+            bool ok = separated && std::abs(distance - expected) <= tolerance &&
+                      std::abs(glm::length(pb - pa) - expected) <= tolerance;
+            if (!ok && failures[c]++ < 5) {
+                std::printf("FAIL %s query %u: distance %g, |pb - pa| %g, expected %g\n", names[c], q, distance,
+                            glm::length(pb - pa), expected);
+            }
+        }
+    }
+
+    uint32_t total = 0;
+    for (uint32_t c = 0; c < 3; c++) {
+        std::printf("%s: %u / %u wrong\n", names[c], failures[c], tested);
+        total += failures[c];
+    }
+    return total == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+// obb_vs_obb() against a separating axis test done directly on the world axes: away from
+// touching, both must agree on whether random boxes overlap
+
+#include "physics/narrowphase.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#define TEST_PAIRS 200000
+#define TEST_MARGIN 1e-3f  // pairs within this of touching on some axis are skipped
+
+static WorldOBB random_box(std::mt19937& rng) {
+    std::uniform_real_distribution<float> U(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> S(0.1f, 3.0f);
+
+    WorldOBB o;
+    o.center = glm::vec3(U(rng), U(rng), U(rng)) * 4.0f;
+    o.half_extents = glm::vec3(S(rng), S(rng), S(rng));
+    glm::mat3 m = glm::mat3_cast(glm::normalize(glm::quat(U(rng), U(rng), U(rng), U(rng))));
+    for (uint32_t k = 0; k < 3; k++) {
+        o.axes[k] = glm::normalize(m[k]);
+    }
+    return o;
+}
+
+static float radius_along(const WorldOBB& o, const glm::vec3& n) {
+    return o.half_extents[0] * std::abs(glm::dot(o.axes[0], n)) + o.half_extents[1] * std::abs(glm::dot(o.axes[1], n)) +
+           o.half_extents[2] * std::abs(glm::dot(o.axes[2], n));
+}
+
+// Largest gap between the boxes over the 15 axes, negative when none separates them
+static float largest_gap(const WorldOBB& A, const WorldOBB& B) {
+    glm::vec3 axes[15];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < 3; i++) {
+        axes[count++] = A.axes[i];
+        axes[count++] = B.axes[i];
+        for (uint32_t j = 0; j < 3; j++) {
+            glm::vec3 n = glm::cross(A.axes[i], B.axes[j]);
+            if (glm::dot(n, n) > 1e-6f) {
+                axes[count++] = glm::normalize(n);
+            }
+        }
+    }
+
+    float gap = -1e30f;
+    for (uint32_t k = 0; k < count; k++) {
+        float d = std::abs(glm::dot(B.center - A.center, axes[k]));
+        gap = std::max(gap, d - radius_along(A, axes[k]) - radius_along(B, axes[k]));
+    }
+    return gap;
+}
+
+int main() {
+    std::mt19937 rng(5);
+    uint32_t tested = 0;
+    uint32_t failures = 0;
+
+    for (uint32_t i = 0; i < TEST_PAIRS; i++) {
+        WorldOBB A = random_box(rng);
+        WorldOBB B = random_box(rng);
+        float gap = largest_gap(A, B);
+        if (std::abs(gap) < TEST_MARGIN) {
+            continue;
+        }
+        tested++;
+
+        Contact c;
+        bool overlaps = obb_vs_obb(1, A, 2, B, c);
+        if (overlaps != (gap < 0.0f) && failures++ < 5) {
+            std::printf("FAIL pair %u: obb_vs_obb %s, gap %g\n", i, overlaps ? "overlaps" : "separated", gap);
+        }
+    }
+
+    std::printf("%u / %u wrong\n", failures, tested);
+    return failures == 0 ? 0 : 1;
+}
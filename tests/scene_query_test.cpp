@@ -0,0 +1,310 @@
+// SceneQuery against casting every shape one by one: raycast, raycast_batch and sphere_cast
+// must find the same hits, before and after shapes move, change layer, come and go
+
+#include "physics/scene_query.h"
+#include "physics/collision_mesh.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#define TEST_SHAPES 400
+#define TEST_RAYS 2000
+#define TEST_RADIUS 0.3f
+#define TEST_TOLERANCE 1e-3f  // on distances, casts that stop early may converge a little differently
+
+struct TestShape {
+    ColliderType type = ColliderType::OBB;
+    WorldSphere sphere;
+    WorldOBB obb;
+    WorldCapsule capsule;
+    WorldConvex convex;
+    WorldMesh mesh;
+    LayerMask layer = 1;
+    bool is_trigger = false;
+    bool live = false;
+};
+
+struct Scene {
+    std::vector<TestShape> shapes;  // by slot, the entity is the slot + 1
+    ConvexHull hull;
+    TriangleMesh terrain;
+    SceneQuery queries;
+};
+
+static EntityID entity_of(uint32_t slot) {
+    return slot + 1;
+}
+
+static glm::mat3 random_rotation(std::mt19937& rng) {
+    std::uniform_real_distribution<float> U(-1.0f, 1.0f);
+    return glm::mat3_cast(glm::normalize(glm::quat(U(rng), U(rng), U(rng), U(rng))));
+}
+
+// Anything but a mesh, spread over a 40m cube
+static TestShape random_shape(Scene& scene, std::mt19937& rng) {
+    std::uniform_real_distribution<float> U(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> S(0.2f, 2.0f);
+
+    TestShape s;
+    glm::vec3 center = glm::vec3(U(rng), U(rng), U(rng)) * 20.0f;
+    s.type = static_cast<ColliderType>(rng() % 4);
+    switch (s.type) {
+        case ColliderType::OBB: {
+            glm::mat3 m = random_rotation(rng);
+            s.obb.center = center;
+            s.obb.half_extents = glm::vec3(S(rng), S(rng), S(rng));
+            for (uint32_t k = 0; k < 3; k++) {
+                s.obb.axes[k] = glm::normalize(m[k]);
+            }
+            break;
+        }
+        case ColliderType::Sphere: {
+            s.sphere.center = center;
+            s.sphere.radius = S(rng);
+            break;
+        }
+        case ColliderType::Capsule: {
+            glm::vec3 half = random_rotation(rng)[0] * S(rng);
+            s.capsule.p0 = center - half;
+            s.capsule.p1 = center + half;
+            s.capsule.radius = S(rng) * 0.5f;
+            break;
+        }
+        default: {
+            s.type = ColliderType::Convex;
+            s.convex.hull = &scene.hull;
+            s.convex.basis = random_rotation(rng) * S(rng);
+            s.convex.origin = center;
+            break;
+        }
+    }
+    s.layer = 1u << (rng() % 3);
+    s.is_trigger = rng() % 8 == 0;
+    s.live = true;
+    return s;
+}
+
+static void set(Scene& scene, uint32_t slot, const TestShape& s) {
+    if (slot >= scene.shapes.size()) {
+        scene.shapes.resize(slot + 1);
+    }
+    scene.shapes[slot] = s;
+
+    switch (s.type) {
+        case ColliderType::OBB: {
+            scene.queries.set(slot, entity_of(slot), s.obb, s.layer, s.is_trigger);
+            break;
+        }
+        case ColliderType::Sphere: {
+            scene.queries.set(slot, entity_of(slot), s.sphere, s.layer, s.is_trigger);
+            break;
+        }
+        case ColliderType::Capsule: {
+            scene.queries.set(slot, entity_of(slot), s.capsule, s.layer, s.is_trigger);
+            break;
+        }
+        case ColliderType::Convex: {
+            scene.queries.set(slot, entity_of(slot), s.convex, s.layer, s.is_trigger);
+            break;
+        }
+        default: {
+            scene.queries.set(slot, entity_of(slot), s.mesh, s.layer, s.is_trigger);
+            break;
+        }
+    }
+}
+
+static bool cast(const TestShape& s, const glm::vec3& o, const glm::vec3& d, float radius, float tmax, RayHit& hit) {
+    switch (s.type) {
+        case ColliderType::OBB: {
+            return cast_obb(s.obb, o, d, radius, tmax, hit);
+        }
+        case ColliderType::Sphere: {
+            return cast_sphere(s.sphere, o, d, radius, tmax, hit);
+        }
+        case ColliderType::Capsule: {
+            return cast_capsule(s.capsule, o, d, radius, tmax, hit);
+        }
+        case ColliderType::Convex: {
+            return cast_convex(s.convex, o, d, radius, tmax, hit);
+        }
+        default: {
+            return cast_mesh(s.mesh, o, d, radius, tmax, hit);
+        }
+    }
+}
+
+// Every hit of the ray, sorted by entity
+static std::vector<RayHit> brute_force(const Scene& scene, const Ray& ray, float radius, const QueryFilter& filter) {
+    std::vector<RayHit> hits;
+    glm::vec3 d = glm::normalize(ray.direction);
+    for (uint32_t slot = 0; slot < scene.shapes.size(); slot++) {
+        const TestShape& s = scene.shapes[slot];
+        if (!s.live || !(s.layer & filter.layers) || (s.is_trigger && !filter.include_triggers) ||
+            entity_of(slot) == filter.ignore) {
+            continue;
+        }
+
+        RayHit hit;
+        if (cast(s, ray.origin, d, radius, ray.max_distance, hit)) {
+            hit.entity = entity_of(slot);
+            hits.push_back(hit);
+        }
+    }
+    return hits;
+}
+
+static bool by_entity(const RayHit& a, const RayHit& b) {
+    return a.entity < b.entity;
+}
+
+// Compares a query's hits of one ray against the brute force ones, returns the mismatches
+static uint32_t check(std::vector<RayHit> expected, std::vector<RayHit> got, QueryMode mode, const char* name,
+                      uint32_t ray) {
+    bool ok = true;
+    if (mode == QueryMode::All) {
+        for (uint32_t i = 1; i < got.size(); i++) {
+            ok = ok && got[i - 1].distance <= got[i].distance;
+        }
+
+        std::sort(expected.begin(), expected.end(), by_entity);
+        std::sort(got.begin(), got.end(), by_entity);
+        ok = ok && expected.size() == got.size();
+        for (uint32_t i = 0; ok && i < got.size(); i++) {
+            ok = expected[i].entity == got[i].entity &&
+                 std::abs(expected[i].distance - got[i].distance) <= TEST_TOLERANCE;
+        }
+    } else if (expected.empty() || got.empty()) {
+        ok = expected.empty() && got.empty();
+    } else {
+        // Any hit will do for Any, the nearest one for Closest
+        auto it = std::find_if(expected.begin(), expected.end(),
+                               [&](const RayHit& h) { return h.entity == got[0].entity; });
+        float nearest = FLT_MAX;
+        for (const RayHit& h : expected) {
+            nearest = std::min(nearest, h.distance);
+        }
+        ok = got.size() == 1 && it != expected.end() && std::abs(it->distance - got[0].distance) <= TEST_TOLERANCE &&
+             (mode == QueryMode::Any || got[0].distance <= nearest + TEST_TOLERANCE);
+    }
+
+    if (!ok) {
+        std::printf("FAIL %s ray %u: %zu hits, expected %zu\n", name, ray, got.size(), expected.size());
+    }
+    return ok ? 0 : 1;
+}
+
+static uint32_t check_queries(Scene& scene, std::mt19937& rng, const char* phase) {
+    std::uniform_real_distribution<float> U(-1.0f, 1.0f);
+
+    std::vector<Ray> rays(TEST_RAYS);
+    for (uint32_t i = 0; i < TEST_RAYS; i++) {
+        // Bundles of four rays from one origin, like a batch of line of sight checks
+        rays[i].origin = i % 4 == 0 ? glm::vec3(U(rng), U(rng), U(rng)) * 25.0f : rays[i - 1].origin;
+        rays[i].direction = glm::vec3(U(rng), U(rng), U(rng));
+        rays[i].max_distance = rng() % 2 ? FLT_MAX : 30.0f;
+    }
+
+    QueryFilter filters[2];
+    filters[1].layers = 1u | 4u;
+    filters[1].include_triggers = true;
+    filters[1].ignore = entity_of(0);
+
+    uint32_t failures = 0;
+    QueryMode modes[3] = {QueryMode::Closest, QueryMode::Any, QueryMode::All};
+    for (const QueryFilter& filter : filters) {
+        for (QueryMode mode : modes) {
+            RayBatchHits batch;
+            scene.queries.raycast_batch(rays, mode, batch, filter);
+
+            for (uint32_t i = 0; i < TEST_RAYS; i++) {
+                std::vector<RayHit> expected = brute_force(scene, rays[i], 0.0f, filter);
+                std::vector<RayHit> got;
+                scene.queries.raycast(rays[i], mode, got, filter);
+                failures += check(expected, got, mode, "raycast", i);
+
+                std::vector<RayHit> batched(batch.hits.begin() + batch.offsets[i],
+                                            batch.hits.begin() + batch.offsets[i + 1]);
+                failures += check(expected, batched, mode, "raycast_batch", i);
+
+                std::vector<RayHit> swept_expected = brute_force(scene, rays[i], TEST_RADIUS, filter);
+                std::vector<RayHit> swept;
+                scene.queries.sphere_cast(rays[i], TEST_RADIUS, mode, swept, filter);
+                failures += check(swept_expected, swept, mode, "sphere_cast", i);
+            }
+        }
+    }
+
+    std::printf("%s: %u shapes, %u mismatches\n", phase, scene.queries.size(), failures);
+    return failures;
+}
+
+int main() {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> U(-1.0f, 1.0f);
+    Scene scene;
+
+    std::vector<glm::vec3> points;
+    for (uint32_t i = 0; i < 64; i++) {
+        points.push_back(glm::normalize(glm::vec3(U(rng), U(rng), U(rng))) * glm::vec3(1.0f, 0.5f, 0.8f));
+    }
+    scene.hull.build(points);
+
+    // A bumpy floor under everything
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    for (uint32_t z = 0; z <= 8; z++) {
+        for (uint32_t x = 0; x <= 8; x++) {
+            vertices.push_back(glm::vec3(x * 5.0f - 20.0f, U(rng) - 22.0f, z * 5.0f - 20.0f));
+        }
+    }
+    for (uint32_t z = 0; z < 8; z++) {
+        for (uint32_t x = 0; x < 8; x++) {
+            uint32_t i = z * 9 + x;
+            indices.insert(indices.end(), {i, i + 9, i + 1, i + 1, i + 9, i + 10});
+        }
+    }
+    scene.terrain.add(vertices, indices);
+    scene.terrain.build();
+
+    TestShape floor;
+    floor.type = ColliderType::Mesh;
+    floor.mesh.mesh = &scene.terrain;
+    floor.live = true;
+    set(scene, 0, floor);
+    for (uint32_t slot = 1; slot < TEST_SHAPES; slot++) {
+        set(scene, slot, random_shape(scene, rng));
+    }
+
+    uint32_t failures = check_queries(scene, rng, "built");
+
+    // Moving shapes and changing layers only refits the tree
+    for (uint32_t slot = 1; slot < TEST_SHAPES; slot += 3) {
+        set(scene, slot, random_shape(scene, rng));
+    }
+    for (uint32_t slot = 2; slot < TEST_SHAPES; slot += 7) {
+        scene.shapes[slot].layer = 1u << (rng() % 3);
+        scene.shapes[slot].is_trigger = !scene.shapes[slot].is_trigger;
+        scene.queries.set_filter(slot, scene.shapes[slot].layer, scene.shapes[slot].is_trigger);
+    }
+    failures += check_queries(scene, rng, "refit");
+
+    // Removing shapes, then adding some in the freed slots and some past the end
+    for (uint32_t slot = 1; slot < TEST_SHAPES; slot += 4) {
+        scene.shapes[slot].live = false;
+        scene.queries.remove(slot);
+    }
+    for (uint32_t slot = 1; slot < TEST_SHAPES; slot += 8) {
+        set(scene, slot, random_shape(scene, rng));
+    }
+    for (uint32_t slot = TEST_SHAPES; slot < TEST_SHAPES + 50; slot++) {
+        set(scene, slot, random_shape(scene, rng));
+    }
+    failures += check_queries(scene, rng, "rebuilt");
+
+    return failures == 0 ? 0 : 1;
+}
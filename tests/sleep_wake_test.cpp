@@ -0,0 +1,87 @@
+// A kinematic platform already touching a sleeping box must wake it when it starts
+// moving into it, and push it rather than pass through it
+
+#include "core/engine.h"
+#include "managers/entity_manager.h"
+#include "managers/context_manager.h"
+#include "contexts/collision_context.h"
+#include "contexts/event_context.h"
+#include "contexts/physics_context.h"
+#include "components/transform.h"
+#include "components/collider.h"
+#include "components/rigidbody.h"
+#include "systems/rigidbody_system.h"
+#include "systems/collision_detection_system.h"
+#include "systems/collision_resolution_system.h"
+
+#include <cstdio>
+
+#define TEST_DT (1.0f / 60.0f)
+#define TEST_SETTLE_FRAMES 120  // long enough for the box to fall asleep
+#define TEST_PUSH_FRAMES 60
+#define TEST_PLATFORM_SPEED 1.0f
+#define TEST_TOUCH 0.005f  // platform overlap with the box, under the solver's slop
+
+int main() {
+    Engine engine;
+    ContextManager& cm = engine.cm();
+    cm.add<PhysicsContext>();
+    cm.add<CollisionContext>();
+    cm.add<EventContext>();
+    cm.get<PhysicsContext>().dt = TEST_DT;
+    EntityManager& em = engine.em();
+
+    EntityID floor = em.create_entity("floor");
+    em.add<Transform>(floor, glm::vec3(0.0f, -0.5f, 0.0f)).set_scale(glm::vec3(20.0f, 1.0f, 20.0f));
+    em.add<RigidBody>(floor, 0.0f, true);
+    em.add<Collider>(floor).layer = Layers::Ground;
+
+    EntityID box = em.create_entity("box");
+    em.add<Transform>(box, glm::vec3(0.0f, 0.5f, 0.0f));
+    em.add<RigidBody>(box, 1.0f);
+    em.add<Collider>(box);
+
+    // Raised off the floor, touching the box's -x face
+    EntityID platform = em.create_entity("platform");
+    em.add<Transform>(platform, glm::vec3(-1.0f + TEST_TOUCH, 0.6f, 0.0f));
+    em.add<RigidBody>(platform, 1.0f, false, true);
+    em.add<Collider>(platform);
+
+    RigidBodySystem rbs;
+    CollisionDetectionSystem cds;
+    CollisionResolutionSystem crs;
+    rbs.init(engine);
+    cds.init(engine);
+    crs.init(engine);
+
+    auto step = [&]() {
+        RigidBody& rb = em.get_component<RigidBody>(platform);
+        em.get_component<Transform>(platform).update_position(rb.velocity * TEST_DT);
+        rbs.update(engine);
+        cds.update(engine);
+        crs.update(engine);
+    };
+
+    for (uint32_t f = 0; f < TEST_SETTLE_FRAMES; f++) {
+        step();
+    }
+    if (!em.get_component<RigidBody>(box).is_sleeping) {
+        std::printf("FAIL the box never fell asleep\n");
+        return 1;
+    }
+
+    em.get_component<RigidBody>(platform).velocity = glm::vec3(TEST_PLATFORM_SPEED, 0.0f, 0.0f);
+    bool woke = false;
+    for (uint32_t f = 0; f < TEST_PUSH_FRAMES; f++) {
+        step();
+        woke = woke || !em.get_component<RigidBody>(box).is_sleeping;
+    }
+
+    // The boxes are a unit wide, the box must stay ahead of the platform's face
+    float platform_x = em.get_component<Transform>(platform).position().x;
+    float box_x = em.get_component<Transform>(box).position().x;
+    float overlap = platform_x + 1.0f - box_x;
+    std::printf("box %s, platform at x=%.3f, box at x=%.3f, overlap %.3f\n", woke ? "woke" : "slept", platform_x, box_x,
+                overlap);
+    return woke && overlap < 0.1f ? 0 : 1;
+}